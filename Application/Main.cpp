@@ -1,16 +1,86 @@
 #include <Engine.h>
 #include <iostream>
+#include <string>
+
+static void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " scenePath outputPath [options]" << std::endl;
+	std::cout << "scenePath - path to the json file with the scene description" << std::endl;
+	std::cout << "outputPath - path to the output image, .jpg, .png, .hdr, .pfm or .exr" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --threads N - number of render threads, 0 uses all hardware threads (default 0)" << std::endl;
+	std::cout << "  --tile-size N - width and height of a render tile in pixels (default 16)" << std::endl;
+	std::cout << "  --packet-size N - primary rays traced together, 1, 4, 8 or 16 (default 8)" << std::endl;
+	std::cout << "  --progressive - render coarse blocks first and write a preview after every refinement pass" << std::endl;
+	std::cout << "  --stream - write tiles to the output as they finish instead of holding the whole image, .png, .pfm or .exr only" << std::endl;
+	std::cout << "  --time-limit S - stop after S seconds and write the image as far as it got" << std::endl;
+	std::cout << "  --samples N - adaptive anti-aliasing with up to N samples per pixel (default 1, no anti-aliasing)" << std::endl;
+	std::cout << "  --aa-threshold T - color difference between samples that makes a pixel take more of them (default 0.05)" << std::endl;
+	std::cout << "  --cache DIR - keep loaded meshes and textures in DIR, later renders of scenes using the same files start faster" << std::endl;
+	std::cout << "  --stats - print ray, intersection and timing statistics at the end" << std::endl;
+	std::cout << "  --stats-json PATH - write the statistics to a JSON file" << std::endl;
+}
 
 int main(int argc, char* argv[])
 {
-	if (argc != 3 || strcmp(argv[1], "--help") == 0) {
-		std::cout << "Usage: " << argv[0] << " scenePath outputPath" <<std::endl;
-		std::cout << "scenePath - path to the json file with the scene description" << std::endl;
-		std::cout << "outputPath - path to the output image" << std::endl;
+	if (argc < 3 || strcmp(argv[1], "--help") == 0) {
+		printUsage(argv[0]);
 		return -1;
 	}
 
 	std::string scene = argv[1];
 	std::string output = argv[2];
-	Engine::renderToFile(scene, output);
+	RenderSettings settings;
+
+	for (int i = 3; i < argc; i++) {
+		std::string option = argv[i];
+		if (option == "--progressive") {
+			settings.progressive = true;
+			continue;
+		}
+		if (option == "--stream") {
+			settings.streamOutput = true;
+			continue;
+		}
+		if (option == "--stats") {
+			settings.printStats = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			printUsage(argv[0]);
+			return -1;
+		}
+
+		if (option == "--threads") {
+			settings.threadCount = std::stoi(argv[++i]);
+		}
+		else if (option == "--tile-size") {
+			settings.tileSize = std::stoi(argv[++i]);
+		}
+		else if (option == "--packet-size") {
+			settings.packetSize = std::stoi(argv[++i]);
+		}
+		else if (option == "--time-limit") {
+			settings.timeLimit = std::stod(argv[++i]);
+		}
+		else if (option == "--samples") {
+			settings.maxSamples = std::stoi(argv[++i]);
+		}
+		else if (option == "--aa-threshold") {
+			settings.contrastThreshold = std::stod(argv[++i]);
+		}
+		else if (option == "--cache") {
+			settings.cacheDirectory = argv[++i];
+		}
+		else if (option == "--stats-json") {
+			settings.statsPath = argv[++i];
+		}
+		else {
+			printUsage(argv[0]);
+			return -1;
+		}
+	}
+
+	Engine::renderToFile(scene, output, settings);
 }
@@ -0,0 +1,22 @@
+#include "Benchmark.h"
+
+volatile double Benchmark::sink = 0;
+
+nlohmann::json BenchmarkResult::toJSON() const
+{
+    nlohmann::json json;
+    json["name"] = name;
+    if (!error.empty()) {
+        json["error"] = error;
+        return json;
+    }
+
+    json["iterations"] = iterations;
+    json["seconds"] = seconds;
+    json["nsPerOp"] = nsPerOp;
+    if (rays > 0) {
+        json["rays"] = rays;
+        json["raysPerSecond"] = raysPerSecond;
+    }
+    return json;
+}
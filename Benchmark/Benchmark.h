@@ -0,0 +1,59 @@
+#pragma once
+#include <RenderSettings.h>
+#include <json.hpp>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Outcome of one benchmark. Micro benchmarks fill in nsPerOp, scene renders also fill in the ray counts.
+struct BenchmarkResult {
+    std::string name;
+    long long iterations = 0;
+    double seconds = 0;
+    double nsPerOp = 0;
+    long long rays = 0;
+    double raysPerSecond = 0;
+    // Set instead of the measurements when the benchmark could not run, e.g. a scene refers to a missing texture.
+    std::string error;
+
+    nlohmann::json toJSON() const;
+};
+
+namespace Benchmark {
+    // Folds the results of the measured operations into a value the compiler has to keep.
+    extern volatile double sink;
+
+    // Calls op in batches of growing size until at least minSeconds have passed.
+    // op returns a value derived from its work, so the call can't be optimized away.
+    template <typename Op>
+    BenchmarkResult measure(const std::string &name, double minSeconds, Op op)
+    {
+        using Clock = std::chrono::steady_clock;
+        BenchmarkResult result;
+        result.name = name;
+
+        long long batch = 1;
+        double elapsed = 0;
+        while (elapsed < minSeconds) {
+            double accumulated = 0;
+            const Clock::time_point start = Clock::now();
+            for (long long i = 0; i < batch; i++) {
+                accumulated += op();
+            }
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+            sink = sink + accumulated;
+            result.iterations += batch;
+            batch *= 2;
+        }
+
+        result.seconds = elapsed;
+        result.nsPerOp = elapsed * 1e9 / result.iterations;
+        return result;
+    }
+
+    std::vector<BenchmarkResult> runMicroBenchmarks(double minSeconds);
+
+    // Renders every scene of the directory whose name is in sceneNames, with the camera resolution multiplied by scale.
+    std::vector<BenchmarkResult> runSceneBenchmarks(const std::string &sceneDirectory, const std::vector<std::string> &sceneNames,
+        double scale, double minSeconds, const RenderSettings &settings);
+}
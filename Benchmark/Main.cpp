@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+static void printUsage(const char* program)
+{
+	std::cout << "Usage: " << program << " [options]" << std::endl;
+	std::cout << "Runs the micro benchmarks and renders the scenes of Renders/ at a reduced resolution." << std::endl;
+	std::cout << "Results go to stdout as JSON, nsPerOp is per call or per render, raysPerSecond counts every ray type." << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --output PATH - write the JSON results to a file instead of stdout" << std::endl;
+	std::cout << "  --scenes DIR - directory of skybox.json, soft_shadows.json and various.json (default ../Application/Scenes)" << std::endl;
+	std::cout << "  --scale F - factor applied to the camera resolution of the scenes (default 0.1)" << std::endl;
+	std::cout << "  --min-time S - seconds every benchmark runs for at least (default 0.5)" << std::endl;
+	std::cout << "  --threads N - render threads of the scene benchmarks, 0 uses all hardware threads (default 0)" << std::endl;
+	std::cout << "  --packet-size N - primary rays traced together in the scene benchmarks (default 8)" << std::endl;
+	std::cout << "  --no-micro - skip the micro benchmarks" << std::endl;
+	std::cout << "  --no-scenes - skip the scene benchmarks" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string outputPath;
+	std::string sceneDirectory = "../Application/Scenes";
+	double scale = 0.1;
+	double minSeconds = 0.5;
+	bool runMicro = true;
+	bool runScenes = true;
+	RenderSettings settings;
+	settings.reportProgress = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string option = argv[i];
+		if (option == "--no-micro") {
+			runMicro = false;
+			continue;
+		}
+		if (option == "--no-scenes") {
+			runScenes = false;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			printUsage(argv[0]);
+			return -1;
+		}
+
+		if (option == "--output") {
+			outputPath = argv[++i];
+		}
+		else if (option == "--scenes") {
+			sceneDirectory = argv[++i];
+		}
+		else if (option == "--scale") {
+			scale = std::stod(argv[++i]);
+		}
+		else if (option == "--min-time") {
+			minSeconds = std::stod(argv[++i]);
+		}
+		else if (option == "--threads") {
+			settings.threadCount = std::stoi(argv[++i]);
+		}
+		else if (option == "--packet-size") {
+			settings.packetSize = std::stoi(argv[++i]);
+		}
+		else {
+			printUsage(argv[0]);
+			return -1;
+		}
+	}
+
+	nlohmann::json report;
+	report["scale"] = scale;
+	report["threads"] = settings.threadCount;
+	report["packetSize"] = settings.packetSize;
+	report["benchmarks"] = nlohmann::json::array();
+
+	std::vector<BenchmarkResult> results;
+	if (runMicro) {
+		results = Benchmark::runMicroBenchmarks(minSeconds);
+	}
+	if (runScenes) {
+		std::vector<BenchmarkResult> scenes = Benchmark::runSceneBenchmarks(sceneDirectory, { "skybox", "soft_shadows", "various" },
+			scale, minSeconds, settings);
+		results.insert(results.end(), scenes.begin(), scenes.end());
+	}
+
+	for (const BenchmarkResult &result : results) {
+		report["benchmarks"].push_back(result.toJSON());
+		if (!result.error.empty()) {
+			std::cerr << result.name << ": " << result.error << std::endl;
+		}
+	}
+
+	if (outputPath.empty()) {
+		std::cout << report.dump(2) << std::endl;
+		return 0;
+	}
+
+	std::ofstream output(outputPath);
+	if (!output) {
+		std::cerr << "Could not write the results to: " << outputPath << std::endl;
+		return -1;
+	}
+	output << report.dump(2) << std::endl;
+}
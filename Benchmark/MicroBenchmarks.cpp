@@ -0,0 +1,164 @@
+#include "Benchmark.h"
+#include <Camera.h>
+#include <Hit.h>
+#include <ImageIOInterface.h>
+#include <Matrix4.h>
+#include <World.h>
+#include <Shapes/Cube.h>
+#include <Shapes/Sphere.h>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+static const double PI = 3.14159265;
+
+// Camera rays over the default world, so the world benchmarks see a realistic mix of hits and misses.
+static std::vector<Ray> cameraRays(int size)
+{
+    Camera camera = Camera::makeCamera(size, size, PI / 3);
+    camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 1.5, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+    std::vector<Ray> rays;
+    rays.reserve(size * size);
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            rays.push_back(camera.rayForPixel(x, y));
+        }
+    }
+    return rays;
+}
+
+struct PreparedRay {
+    Ray ray;
+    std::vector<Intersection> all;
+    Intersection hit;
+};
+
+// Intersections of the rays that hit something, ready to be passed to prepareHit.
+static std::vector<PreparedRay> prepareRays(const World &world, const std::vector<Ray> &rays)
+{
+    std::vector<PreparedRay> result;
+    for (const Ray &ray : rays) {
+        std::vector<Intersection> all = world.intersectsToHit(ray);
+        std::optional<Intersection> hit = Intersection::hit(all);
+        if (hit.has_value()) {
+            result.push_back(PreparedRay{ ray, all, hit.value() });
+        }
+    }
+    return result;
+}
+
+std::vector<BenchmarkResult> Benchmark::runMicroBenchmarks(double minSeconds)
+{
+    std::vector<BenchmarkResult> results;
+
+    // The matrix benchmarks feed every result into the next call, so nothing can be hoisted out of the loop.
+    // Rotations keep the product from growing, and inverting twice returns to the start.
+    {
+        Matrix4 product = Matrix4::identity();
+        const Matrix4 rotation = Matrix4::rotationX(0.3) * Matrix4::rotationY(0.7);
+        results.push_back(measure("Matrix4::operator*", minSeconds, [&]() {
+            product = product * rotation;
+            return product(0, 0);
+        }));
+    }
+    {
+        Matrix4 affine = Matrix4::translation(1, -2, 3) * Matrix4::rotationZ(0.4) * Matrix4::scaling(2, 3, 4);
+        results.push_back(measure("Matrix4::inverse (affine)", minSeconds, [&]() {
+            affine = Matrix4::inverse(affine);
+            return affine(0, 3);
+        }));
+    }
+    {
+        Matrix4 projective = Matrix4::translation(1, -2, 3) * Matrix4::rotationZ(0.4);
+        projective(3, 0) = 0.1;
+        projective(3, 1) = 0.2;
+        projective(3, 2) = 0.3;
+        results.push_back(measure("Matrix4::inverse (general)", minSeconds, [&]() {
+            projective = Matrix4::inverse(projective);
+            return projective(0, 3);
+        }));
+    }
+
+    // The shape benchmarks sweep the ray origin so consecutive calls don't see identical input.
+    std::vector<Intersection> xs;
+    long long call = 0;
+    {
+        std::shared_ptr<Sphere> sphere = Sphere::createSphere();
+        sphere->setTransform(Matrix4::translation(0, 0, 1) * Matrix4::scaling(2, 2, 2));
+        results.push_back(measure("Sphere::intersects", minSeconds, [&]() {
+            const Ray ray(Tuple::point((call++ & 15) * 0.1, 0, -5), Tuple::vector(0, 0, 1));
+            xs.clear();
+            sphere->intersects(ray, xs);
+            return xs.empty() ? 0.0 : xs[0].getT();
+        }));
+    }
+    {
+        std::shared_ptr<Cube> cube = Cube::createCube();
+        cube->setTransform(Matrix4::rotationY(0.5) * Matrix4::scaling(2, 2, 2));
+        results.push_back(measure("Cube::intersects", minSeconds, [&]() {
+            const Ray ray(Tuple::point((call++ & 15) * 0.1, 0, -5), Tuple::vector(0, 0, 1));
+            xs.clear();
+            cube->intersects(ray, xs);
+            return xs.empty() ? 0.0 : xs[0].getT();
+        }));
+    }
+
+    World world = World::makeDefaultWorld();
+    world.buildAccelerationStructure();
+    const std::vector<Ray> rays = cameraRays(32);
+    size_t next = 0;
+    results.push_back(measure("World::intersects", minSeconds, [&]() {
+        const Ray &ray = rays[next++ % rays.size()];
+        xs.clear();
+        world.intersects(ray, xs);
+        return xs.empty() ? 0.0 : xs[0].getT();
+    }));
+    results.push_back(measure("World::intersectsToHit", minSeconds, [&]() {
+        const Ray &ray = rays[next++ % rays.size()];
+        xs.clear();
+        world.intersectsToHit(ray, xs);
+        return xs.empty() ? 0.0 : xs[0].getT();
+    }));
+
+    // prepareHit gets the full intersection list of every ray that hits something, as colorAt passes it.
+    // The glass variant makes the spheres transparent, which is when refractive indices have to be resolved.
+    World glassWorld = World::makeDefaultWorld();
+    for (int i = 0; i < glassWorld.getObjectCount(); i++) {
+        glassWorld.getObject(i)->getMaterial().transparency = 1.0;
+        glassWorld.getObject(i)->getMaterial().refractiveIndex = 1.5;
+    }
+    glassWorld.buildAccelerationStructure();
+    const std::pair<const char*, const World*> prepareHitWorlds[2] = {
+        { "Intersection::prepareHit", &world },
+        { "Intersection::prepareHit (glass)", &glassWorld }
+    };
+    for (const auto &[name, prepareHitWorld] : prepareHitWorlds) {
+        const std::vector<PreparedRay> hits = prepareRays(*prepareHitWorld, rays);
+        if (hits.empty()) {
+            continue;
+        }
+        results.push_back(measure(name, minSeconds, [&]() {
+            const PreparedRay &prepared = hits[next++ % hits.size()];
+            const Hit hit = prepared.hit.prepareHit(prepared.ray, prepared.all);
+            return hit.normalv[0] + hit.n2;
+        }));
+    }
+
+    {
+        Canvas canvas(256, 256);
+        for (int y = 0; y < canvas.height; y++) {
+            for (int x = 0; x < canvas.width; x++) {
+                canvas.set(x, y, Color(x / 255.0, y / 255.0, ((x ^ y) & 255) / 255.0));
+            }
+        }
+        const std::string path = (std::filesystem::temp_directory_path() / "raymond_benchmark.jpg").string();
+        results.push_back(measure("ImageIOInterface::saveToImage (256x256)", minSeconds, [&]() {
+            ImageIOInterface::saveToImage(canvas, path);
+            return 1.0;
+        }));
+        std::remove(path.c_str());
+    }
+
+    return results;
+}
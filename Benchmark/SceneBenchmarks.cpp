@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+#include <Camera.h>
+#include <RenderStats.h>
+#include <SceneParser.h>
+#include <World.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+static BenchmarkResult renderScene(const std::string &path, double scale, double minSeconds, const RenderSettings &settings)
+{
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::invalid_argument("Could not open the scene: " + path);
+    }
+    nlohmann::json sceneJson = nlohmann::json::parse(ifs);
+    for (const char *dimension : { "width", "height" }) {
+        const int size = sceneJson["camera"][dimension];
+        sceneJson["camera"][dimension] = std::max(1, (int) std::lround(size * scale));
+    }
+
+    Camera camera = SceneParser::getCameraFromSceneJSON(sceneJson);
+    World world = SceneParser::getWorldFromSceneJSON(sceneJson);
+    world.setPixelSpread(camera.pixelSize);
+    world.buildAccelerationStructure();
+
+    // Whole renders are repeated until the time is up, the rays of all of them are counted.
+    BenchmarkResult result;
+    RenderStats::reset();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    do {
+        Canvas image = camera.render(world, settings);
+        Benchmark::sink = Benchmark::sink + image.at(0, 0).red;
+        result.iterations++;
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (result.seconds < minSeconds);
+
+    const RenderStats stats = RenderStats::collect();
+    result.rays = stats.primaryRays + stats.shadowRays + stats.reflectionRays + stats.refractionRays;
+    result.raysPerSecond = result.rays / result.seconds;
+    result.nsPerOp = result.seconds * 1e9 / result.iterations;
+    return result;
+}
+
+std::vector<BenchmarkResult> Benchmark::runSceneBenchmarks(const std::string &sceneDirectory, const std::vector<std::string> &sceneNames,
+    double scale, double minSeconds, const RenderSettings &settings)
+{
+    std::vector<BenchmarkResult> results;
+    for (const std::string &name : sceneNames) {
+        BenchmarkResult result;
+        try {
+            result = renderScene(sceneDirectory + "/" + name + ".json", scale, minSeconds, settings);
+        }
+        catch (const std::exception &e) {
+            // A scene that can't be loaded, e.g. because its textures aren't there, doesn't stop the others.
+            result.error = e.what();
+        }
+        result.name = "scene/" + name;
+        results.push_back(result);
+    }
+    return results;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include <Bounds.h>
+#include <Ray.h>
+#include <RenderStats.h>
+#include <vector>
+
+struct BVHNode {
+    Bounds bounds;
+    // Leaves: index of the first primitive in the ordered primitive list.
+    // Interior nodes: index of the second child, the first child always follows its parent.
+    int offset;
+    int count;
+    int axis;
+
+    bool isLeaf() const { return count > 0; }
+};
+
+// Bounding volume hierarchy built with the binned surface area heuristic over a list of primitive bounds.
+// It only stores indices, so the same tree serves shapes in a world and triangles in a mesh.
+class BVH {
+public:
+    static const int MAX_LEAF_SIZE = 4;
+    // Interior nodes on any path from the root, bounded so traversal can keep its stack on the call stack.
+    static const int MAX_DEPTH = 64;
+
+    BVH();
+    explicit BVH(const std::vector<Bounds> &primitiveBounds);
+    // Takes over a tree built before, e.g. one read back from the scene cache. Throws std::invalid_argument when a node
+    // refers past the end of the arrays or the tree is deeper than MAX_DEPTH.
+    BVH(std::vector<BVHNode> nodes, std::vector<int> primitiveIndices);
+
+    bool isEmpty() const;
+    const std::vector<BVHNode>& getNodes() const;
+    const std::vector<int>& getPrimitiveIndices() const;
+    Bounds getBounds() const;
+
+    // Visits primitives front to back, skipping nodes that lie outside [tMin, tMax].
+    // intersectPrimitive(index, tMax) may shrink tMax once it finds a closer hit, returning true ends the traversal.
+    template <typename IntersectPrimitive>
+    void traverse(const Ray &r, double tMin, double &tMax, IntersectPrimitive intersectPrimitive) const;
+
+    // Packet version for closest hit queries: a node is visited while any lane can still find a hit closer than
+    // its tMax[lane], which intersectPrimitive(index) lowers as it records hits. Children are ordered by the first lane.
+    template <typename IntersectPrimitive>
+    void traverse(const RayPacket &packet, const double *tMax, IntersectPrimitive intersectPrimitive) const;
+
+private:
+    std::vector<BVHNode> nodes;
+    std::vector<int> primitiveIndices;
+
+    int build(const std::vector<Bounds> &primitiveBounds, const std::vector<Tuple> &centroids, int begin, int end, int depth);
+    int split(const std::vector<Bounds> &primitiveBounds, const std::vector<Tuple> &centroids, int nodeIndex, int axis, int begin, int middle, int end, int depth);
+};
+
+template <typename IntersectPrimitive>
+void BVH::traverse(const Ray &r, double tMin, double &tMax, IntersectPrimitive intersectPrimitive) const
+{
+    if (nodes.empty()) {
+        return;
+    }
+
+    const Tuple inverseDirection = Bounds::inverseDirection(r);
+    const bool directionNegative[3] = { r.direction[0] < 0, r.direction[1] < 0, r.direction[2] < 0 };
+
+    int stack[MAX_DEPTH];
+    int stackSize = 0;
+    int current = 0;
+    long long visits = 0;
+
+    while (true) {
+        const BVHNode &node = nodes[current];
+        visits++;
+        double tEntry, tExit;
+        if (node.bounds.intersects(r, inverseDirection, tMin, tMax, tEntry, tExit)) {
+            if (node.isLeaf()) {
+                for (int i = node.offset; i < node.offset + node.count; i++) {
+                    if (intersectPrimitive(primitiveIndices[i], tMax)) {
+                        RenderStats::local().bvhNodeVisits += visits;
+                        return;
+                    }
+                }
+            }
+            else {
+                // Descend into the child that is nearer along the split axis first.
+                if (directionNegative[node.axis]) {
+                    stack[stackSize++] = current + 1;
+                    current = node.offset;
+                }
+                else {
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                }
+                continue;
+            }
+        }
+
+        if (stackSize == 0) {
+            break;
+        }
+        current = stack[--stackSize];
+    }
+    RenderStats::local().bvhNodeVisits += visits;
+}
+
+template <typename IntersectPrimitive>
+void BVH::traverse(const RayPacket &packet, const double *tMax, IntersectPrimitive intersectPrimitive) const
+{
+    if (nodes.empty() || packet.size == 0) {
+        return;
+    }
+
+    const bool directionNegative[3] = { packet.directionX[0] < 0, packet.directionY[0] < 0, packet.directionZ[0] < 0 };
+
+    int stack[MAX_DEPTH];
+    int stackSize = 0;
+    int current = 0;
+    long long visits = 0;
+
+    while (true) {
+        const BVHNode &node = nodes[current];
+        visits++;
+        if (node.bounds.intersects(packet, tMax)) {
+            if (node.isLeaf()) {
+                for (int i = node.offset; i < node.offset + node.count; i++) {
+                    intersectPrimitive(primitiveIndices[i]);
+                }
+            }
+            else {
+                if (directionNegative[node.axis]) {
+                    stack[stackSize++] = current + 1;
+                    current = node.offset;
+                }
+                else {
+                    stack[stackSize++] = node.offset;
+                    current = current + 1;
+                }
+                continue;
+            }
+        }
+
+        if (stackSize == 0) {
+            break;
+        }
+        current = stack[--stackSize];
+    }
+    RenderStats::local().bvhNodeVisits += visits;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <Tuple.h>
+#include <Matrix4.h>
+#include <Ray.h>
+#include <RayPacket.h>
+
+// Axis-aligned bounding box. A default constructed box is empty and grows with extend().
+class Bounds {
+public:
+    Tuple min, max;
+
+    Bounds();
+    Bounds(const Tuple &min, const Tuple &max);
+    static Bounds infinite();
+
+    bool isEmpty() const;
+    bool isInfinite() const;
+    void extend(const Tuple &point);
+    void extend(const Bounds &other);
+    Tuple centroid() const;
+    double surfaceArea() const;
+    int largestAxis() const;
+
+    // Entry and exit distances of the ray clipped to [tMin, tMax], inverseDirection is 1 / ray.direction per axis.
+    bool intersects(const Ray &r, const Tuple &inverseDirection, double tMin, double tMax, double &tEntry, double &tExit) const;
+
+    // True when any lane of the packet enters the box within (0, tMax[lane]].
+    bool intersects(const RayPacket &packet, const double *tMax) const;
+
+    static Bounds transform(const Bounds &b, const Matrix4 &m);
+    static Tuple inverseDirection(const Ray &r);
+};
@@ -1,8 +1,11 @@
 #pragma once
-#include <Matrix.h>
+#include <Matrix4.h>
 #include <Ray.h>
 #include <Canvas.h>
 #include <World.h>
+#include <RenderSettings.h>
+#include <RenderStats.h>
+#include <functional>
 
 class Camera {
 public:
@@ -11,14 +14,37 @@ public:
 
     static Camera makeCamera(int h, int v, double fov);
 
-    void setTransform(const Matrix& m);
-    Matrix getTransform() const;
+    void setTransform(const Matrix4& m);
+    Matrix4 getTransform() const;
 
-    Ray rayForPixel(int px, int py);
-    Canvas render(World w);
+    Ray rayForPixel(int px, int py) const;
+    // Ray through the point of the pixel at the given offsets, 0.5 and 0.5 being its center.
+    Ray rayForPixel(int px, int py, double offsetX, double offsetY) const;
+    // Largest block a progressive render starts from.
+    static constexpr int MAX_PROGRESSIVE_STEP = 16;
+    // Samples every pixel gets before anti-aliasing looks at their contrast.
+    static constexpr int INITIAL_SAMPLES = 4;
+
+    // Throws std::invalid_argument for a packet size other than 1, 4, 8 or 16.
+    // onPass gets the image after every progressive pass but the last one. Counters go to RenderStats.
+    Canvas render(const World &w, const RenderSettings &settings = RenderSettings(),
+        const std::function<void(const Canvas&)> &onPass = nullptr) const;
+    // Renders without holding the whole image: every finished tile is passed to onTile with the position of its top left
+    // pixel and dropped afterwards. onTile is called from the render threads, one call at a time. There are no
+    // progressive passes. Past the time limit the remaining tiles are passed on black. The first exception thrown by
+    // onTile stops the render and is rethrown here.
+    void renderTiles(const World &w, const RenderSettings &settings,
+        const std::function<void(const Canvas &tile, int x, int y)> &onTile) const;
 
 private:
-    Matrix transform, inverseTransform;
+    Matrix4 transform, inverseTransform;
     const double halfWidth, halfHeight;
-    Camera(int h, int v, double fov, double pxlSz, const Matrix &m, double halfWidth, double halfHeight);
+    Camera(int h, int v, double fov, double pxlSz, const Matrix4 &m, double halfWidth, double halfHeight);
+
+    // Traces the pixels of a tile on a grid with the given step, filling the step x step block each of them starts.
+    // When refining, pixels on the grid of the previous pass are kept. Pixel (originX, originY) is the top left of image.
+    void renderTile(const World &w, Canvas &image, int originX, int originY, int x0, int y0, int x1, int y1, int step, bool refining,
+        const RenderSettings &settings, const std::function<bool()> &outOfTime) const;
+    // Adaptive anti-aliasing of one pixel.
+    Color renderPixel(const World &w, int px, int py, const RenderSettings &settings) const;
 };
\ No newline at end of file
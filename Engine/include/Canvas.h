@@ -3,6 +3,8 @@
 #include <memory>
 #include <Color.h>
 
+// Linear RGB image. Pixels are stored as three 32-bit floats, half the size of a Color in double precision, and
+// unclamped, so values above 1 survive until the image is written.
 class Canvas {
 public:
     const int width, height;
@@ -11,7 +13,10 @@ public:
     
     Color at(int x, int y) const;
     void set(int x, int y, Color color);
+    // Red, green and blue of every pixel, row by row from the top.
+    const float* data() const;
+    float* data();
 
 private:
-    std::unique_ptr<Color[]> grid;
-};
\ No newline at end of file
+    std::unique_ptr<float[]> pixels;
+};
@@ -1,18 +1,68 @@
 #pragma once
+#include <Real.h>
+
+// Linear RGB color, inline for the same reason as Tuple.
 class Color {
 public:
-    double red, green, blue;
+    Real red, green, blue;
 
-    Color();
-    Color(double r, double g, double b);
+    constexpr Color() : red(0), green(0), blue(0) {}
+    constexpr Color(Real r, Real g, Real b) : red(r), green(g), blue(b) {}
     static const Color black;
     static const Color white;
 
-    bool operator==(const Color &other) const;
-    Color operator+(const Color &other) const;
-    Color operator*(double scalar) const;
-    Color operator*(const Color &other) const;
-    Color operator/(double scalar) const;
-    Color operator-(const Color &other) const;
-    Color operator-() const;
+    constexpr bool operator==(const Color &other) const;
+    constexpr Color operator+(const Color &other) const;
+    constexpr Color operator*(Real scalar) const;
+    constexpr Color operator*(const Color &other) const;
+    constexpr Color operator/(Real scalar) const;
+    constexpr Color operator-(const Color &other) const;
+    constexpr Color operator-() const;
+
+private:
+    static constexpr Real EPSILON = Real(0.0001);
 };
+
+inline const Color Color::black = Color(0, 0, 0);
+inline const Color Color::white = Color(1, 1, 1);
+
+constexpr bool Color::operator==(const Color &other) const
+{
+    const Real differences[3] = { red - other.red, green - other.green, blue - other.blue };
+    for (Real difference : differences) {
+        if (difference >= EPSILON || difference <= -EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr Color Color::operator+(const Color &other) const
+{
+    return Color(red + other.red, green + other.green, blue + other.blue);
+}
+
+constexpr Color Color::operator*(Real scalar) const
+{
+    return Color(red * scalar, green * scalar, blue * scalar);
+}
+
+constexpr Color Color::operator*(const Color &other) const
+{
+    return Color(red * other.red, green * other.green, blue * other.blue);
+}
+
+constexpr Color Color::operator/(Real scalar) const
+{
+    return Color(red / scalar, green / scalar, blue / scalar);
+}
+
+constexpr Color Color::operator-(const Color &other) const
+{
+    return Color(red - other.red, green - other.green, blue - other.blue);
+}
+
+constexpr Color Color::operator-() const
+{
+    return Color(-red, -green, -blue);
+}
@@ -3,7 +3,8 @@
 #include <Camera.h>
 #include <ImageIOInterface.h>
 #include <SceneParser.h>
+#include <RenderSettings.h>
 
 namespace Engine {
-	void renderToFile(std::string scenePath, std::string outputPath);
+	void renderToFile(std::string scenePath, std::string outputPath, const RenderSettings &settings = RenderSettings());
 }
\ No newline at end of file
@@ -9,9 +9,10 @@ public:
     const Tuple normalv;
     const Tuple underPoint, overPoint;
     const Tuple reflectv;
+    // Refractive indices on both sides of the surface, only resolved for transparent materials. Others get 1 and 1.
     const double n1, n2;
 
     Hit(const Intersection &i, const bool ins, const Tuple &p, const Tuple &ev, const Tuple &nv, const Tuple &rv, const double n_1, const double n_2);
 
-    double schlick();
+    double schlick() const;
 };
\ No newline at end of file
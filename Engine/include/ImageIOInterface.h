@@ -1,9 +1,38 @@
 #pragma once
 #include <Canvas.h>
+#include <memory>
 #include <string>
 
+class UVImage;
+
 namespace ImageIOInterface {
+    // The extension of outputPath picks the format:
+    // .jpg/.jpeg (quality 100) and .png store 8 bits per channel, clamped to [0, 1].
+    // .hdr (Radiance RGBE), .pfm (portable float map) and .exr (OpenEXR, 32-bit float, uncompressed) keep the
+    // linear values as rendered, including the ones above 1.
+    // Throws std::invalid_argument for other extensions or when the file can't be written.
     void saveToImage(const Canvas &canvas, std::string outputPath);
+    // Whether saveToImage() knows the extension of path, so a render can fail before it starts.
+    bool isSupportedFormat(const std::string &path);
+
+    // Writes an image tile by tile while it renders, so the whole image never has to be in memory. Tiles may come in
+    // any order but must not overlap. .pfm and .exr put every tile straight into the file. .png has to go top to
+    // bottom, so it holds the rows until the ones above them are complete and stores them uncompressed.
+    class TileWriter {
+    public:
+        virtual ~TileWriter() = default;
+        // The top left pixel of tile is (x, y) in the image.
+        virtual void write(const Canvas &tile, int x, int y) = 0;
+        // Completes the file, every pixel has to be written by then. Throws std::invalid_argument when it can't.
+        virtual void finish() = 0;
+    };
+
+    // Throws std::invalid_argument for formats other than .png, .pfm and .exr, or when the file can't be created.
+    std::unique_ptr<TileWriter> openTileWriter(const std::string &outputPath, int width, int height);
+    bool isStreamableFormat(const std::string &path);
+
     Canvas canvasFromImage(std::string inputPath);
+    // Decodes straight into the 8-bit storage of a texture, which takes a quarter of the memory of a canvas.
+    std::shared_ptr<UVImage> textureFromImage(std::string inputPath);
 }
 
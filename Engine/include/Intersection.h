@@ -9,10 +9,16 @@ class Hit;
 
 class Intersection {
 public:
+    Intersection(double value, const Shape* o);
     Intersection(double value, const std::shared_ptr<const Shape> &o);
+    // Hit on one primitive of a compound shape, u and v are the barycentric coordinates of the hit on it.
+    Intersection(double value, const Shape* o, int primitive, double u, double v);
 
     double getT() const;
-    const std::shared_ptr<const Shape>& getObject() const;
+    const Shape* getObject() const;
+    int getPrimitive() const;
+    double getU() const;
+    double getV() const;
 
     bool operator==(const Intersection &other) const;
 
@@ -21,5 +27,8 @@ public:
 
 private:
     double t;
-    std::shared_ptr<const Shape> object;
+    // Shapes are owned by the world, an intersection never outlives the render it belongs to.
+    const Shape* object;
+    int primitive;
+    double u, v;
 };
\ No newline at end of file
@@ -6,9 +6,22 @@ public:
     Tuple lowerLeftCorner, uVec, vVec, center;
     int uSteps, vSteps, samples;
     bool jitter;
+    // Adaptive shadow sampling, off below 2. Shadow rays first go to a probeSteps x probeSteps lattice spanning the light
+    // from corner to corner, and to its center. When all of them agree, the point is taken to be fully lit or in umbra.
+    // Only the other points cast the full set of samples. Denser lattices miss fewer occluders that fall between probes.
+    int probeSteps = 0;
 
     AreaLight(const Color &c, const Tuple &corner, const Tuple &fullUVec, int usteps, const Tuple &fullVVec, int vsteps, bool sampleJitter);
     
+    // Position on the cell (u, v) of the light, its center or a random point in it when jittered.
     Tuple sample(int u, int v) const;
+    // Position of sample index (0 to samples - 1) as seen from point. Without jitter it's the center of a cell.
+    // With jitter the samples follow the Sobol sequence, scrambled with a seed derived from point, so shadow rays and
+    // shading at one point use the same positions, while neighbouring points don't share a pattern.
+    Tuple samplePosition(int index, const Tuple &point) const;
+    // Number of probes adaptive sampling casts first, 0 when it is off.
+    int probeCount() const;
+    // Position of probe index (0 to probeCount() - 1). Even lattices start with the center, then the lattice follows row by row.
+    Tuple probePosition(int index) const;
     Color lighting(const Tuple & point, Color &color, double ambient, double diffuse, double specular, double shininess, double visibility, const Tuple & eyev, const Tuple & nv) const override;
 };
\ No newline at end of file
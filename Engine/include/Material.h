@@ -3,6 +3,7 @@
 #include <Lights/AreaLight.h>
 #include <Lights/Light.h>
 #include <Texture/Texture.h>
+#include <optional>
 
 class Material {
 public:
@@ -15,10 +16,32 @@ public:
 
     bool operator==(const Material &other) const;
 
-    Color lighting(const Matrix &objectInverseTransform,
+    Color lighting(const Matrix4 &objectInverseTransform,
                    const Light &light,
                    const Tuple &point,
                    const Tuple &eyev,
                    const Tuple &nv,
-                   double intensity) const;
+                   double intensity,
+                   double footprint = 0,
+                   const std::optional<SurfaceUV> &surfaceUV = std::nullopt) const;
+    // The two parts of lighting() on their own. Sampled light selection adds the ambient term of every light
+    // once, but the direct term only for the lights it picks.
+    // footprint is the width of the surface the lookup covers, textures filter over it. A surfaceUV from the shape
+    // is looked up instead of mapping point.
+    Color ambientLighting(const Matrix4 &objectInverseTransform,
+                          const Color &lightIntensity,
+                          const Tuple &point,
+                          double footprint = 0,
+                          const std::optional<SurfaceUV> &surfaceUV = std::nullopt) const;
+    Color directLighting(const Matrix4 &objectInverseTransform,
+                         const Light &light,
+                         const Tuple &point,
+                         const Tuple &eyev,
+                         const Tuple &nv,
+                         double intensity,
+                         double footprint = 0,
+                         const std::optional<SurfaceUV> &surfaceUV = std::nullopt) const;
+
+private:
+    Color colorAt(const Matrix4 &objectInverseTransform, const Tuple &point, double footprint, const std::optional<SurfaceUV> &surfaceUV) const;
 };
\ No newline at end of file
@@ -0,0 +1,255 @@
+#pragma once
+#include <array>
+#include <stdexcept>
+#include <Tuple.h>
+
+// Fixed-size 4x4 transformation matrix. It lives entirely on the stack, so copying one costs sixteen doubles
+// and no allocation. Matrix stays around as the general NxN reference implementation.
+class Matrix4 {
+public:
+    constexpr Matrix4() : grid{} {}
+    constexpr explicit Matrix4(const std::array<double, 16> &values) : grid(values) {}
+
+    static constexpr Matrix4 identity();
+    static constexpr Matrix4 translation(double x, double y, double z);
+    static constexpr Matrix4 scaling(double x, double y, double z);
+    static constexpr Matrix4 shearing(double x_y, double x_z, double y_x, double y_z, double z_x, double z_y);
+    static Matrix4 rotationX(double angle);
+    static Matrix4 rotationY(double angle);
+    static Matrix4 rotationZ(double angle);
+    static Matrix4 viewTransform(const Tuple &from, const Tuple &to, const Tuple &up);
+
+    constexpr double operator()(int row, int column) const { return grid[row * 4 + column]; }
+    constexpr double& operator()(int row, int column) { return grid[row * 4 + column]; }
+    constexpr bool operator==(const Matrix4 &other) const;
+    constexpr Matrix4 operator*(const Matrix4 &other) const;
+    Tuple operator*(const Tuple &other) const;
+
+    static constexpr Matrix4 transpose(const Matrix4 &m);
+    // Same as transpose(m) * t without building the transposed matrix.
+    static Tuple multiplyTransposed(const Matrix4 &m, const Tuple &t);
+    // Transposed inverse without the translation. It takes object-space normals to world space and leaves w at 0,
+    // shapes keep one next to their inverse transform so normalAt() is a single multiplication.
+    static constexpr Matrix4 normalMatrix(const Matrix4 &inverse);
+    static constexpr double determinant(const Matrix4 &m);
+    static constexpr bool isInvertible(const Matrix4 &m);
+    static constexpr bool isAffine(const Matrix4 &m);
+    // Closed-form inverse, affine matrices take the cheaper [R|t]^-1 = [R^-1|-R^-1 t] path.
+    static constexpr Matrix4 inverse(const Matrix4 &m);
+    static constexpr Matrix4 affineInverse(const Matrix4 &m);
+
+private:
+    static constexpr double EPSILON = 0.00001;
+
+    std::array<double, 16> grid;
+};
+
+constexpr Matrix4 Matrix4::identity()
+{
+    return Matrix4({ 1.0, 0.0, 0.0, 0.0,
+                     0.0, 1.0, 0.0, 0.0,
+                     0.0, 0.0, 1.0, 0.0,
+                     0.0, 0.0, 0.0, 1.0 });
+}
+
+constexpr Matrix4 Matrix4::translation(double x, double y, double z)
+{
+    Matrix4 result = identity();
+    result(0, 3) = x;
+    result(1, 3) = y;
+    result(2, 3) = z;
+    return result;
+}
+
+constexpr Matrix4 Matrix4::scaling(double x, double y, double z)
+{
+    Matrix4 result = identity();
+    result(0, 0) = x;
+    result(1, 1) = y;
+    result(2, 2) = z;
+    return result;
+}
+
+constexpr Matrix4 Matrix4::shearing(double x_y, double x_z, double y_x, double y_z, double z_x, double z_y)
+{
+    Matrix4 result = identity();
+    result(0, 1) = x_y;
+    result(0, 2) = x_z;
+    result(1, 0) = y_x;
+    result(1, 2) = y_z;
+    result(2, 0) = z_x;
+    result(2, 1) = z_y;
+    return result;
+}
+
+constexpr bool Matrix4::operator==(const Matrix4 &other) const
+{
+    for (int i = 0; i < 16; i++) {
+        double difference = grid[i] - other.grid[i];
+        if (difference >= EPSILON || difference <= -EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr Matrix4 Matrix4::operator*(const Matrix4 &other) const
+{
+    Matrix4 result;
+    for (int i = 0; i < 4; i++) {
+        const double a0 = grid[i * 4], a1 = grid[i * 4 + 1], a2 = grid[i * 4 + 2], a3 = grid[i * 4 + 3];
+        result.grid[i * 4 + 0] = a0 * other.grid[0] + a1 * other.grid[4] + a2 * other.grid[8] + a3 * other.grid[12];
+        result.grid[i * 4 + 1] = a0 * other.grid[1] + a1 * other.grid[5] + a2 * other.grid[9] + a3 * other.grid[13];
+        result.grid[i * 4 + 2] = a0 * other.grid[2] + a1 * other.grid[6] + a2 * other.grid[10] + a3 * other.grid[14];
+        result.grid[i * 4 + 3] = a0 * other.grid[3] + a1 * other.grid[7] + a2 * other.grid[11] + a3 * other.grid[15];
+    }
+    return result;
+}
+
+inline Tuple Matrix4::operator*(const Tuple &other) const
+{
+    const double x = other[0], y = other[1], z = other[2], w = other[3];
+    return Tuple(grid[0] * x + grid[1] * y + grid[2] * z + grid[3] * w,
+                 grid[4] * x + grid[5] * y + grid[6] * z + grid[7] * w,
+                 grid[8] * x + grid[9] * y + grid[10] * z + grid[11] * w,
+                 grid[12] * x + grid[13] * y + grid[14] * z + grid[15] * w);
+}
+
+constexpr Matrix4 Matrix4::transpose(const Matrix4 &m)
+{
+    Matrix4 result;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result(i, j) = m(j, i);
+        }
+    }
+    return result;
+}
+
+constexpr Matrix4 Matrix4::normalMatrix(const Matrix4 &inverse)
+{
+    Matrix4 result;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            result(i, j) = inverse(j, i);
+        }
+    }
+    return result;
+}
+
+inline Tuple Matrix4::multiplyTransposed(const Matrix4 &m, const Tuple &t)
+{
+    const double x = t[0], y = t[1], z = t[2], w = t[3];
+    return Tuple(m.grid[0] * x + m.grid[4] * y + m.grid[8] * z + m.grid[12] * w,
+                 m.grid[1] * x + m.grid[5] * y + m.grid[9] * z + m.grid[13] * w,
+                 m.grid[2] * x + m.grid[6] * y + m.grid[10] * z + m.grid[14] * w,
+                 m.grid[3] * x + m.grid[7] * y + m.grid[11] * z + m.grid[15] * w);
+}
+
+constexpr double Matrix4::determinant(const Matrix4 &m)
+{
+    // Laplace expansion along the first two rows, sharing the 2x2 minors between the terms.
+    const double s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1);
+    const double s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2);
+    const double s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3);
+    const double s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2);
+    const double s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3);
+    const double s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+
+    const double c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3);
+    const double c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3);
+    const double c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2);
+    const double c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3);
+    const double c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2);
+    const double c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+
+    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+}
+
+constexpr bool Matrix4::isInvertible(const Matrix4 &m)
+{
+    return determinant(m) != 0;
+}
+
+constexpr bool Matrix4::isAffine(const Matrix4 &m)
+{
+    return m(3, 0) == 0.0 && m(3, 1) == 0.0 && m(3, 2) == 0.0 && m(3, 3) == 1.0;
+}
+
+constexpr Matrix4 Matrix4::affineInverse(const Matrix4 &m)
+{
+    const double c00 = m(1, 1) * m(2, 2) - m(1, 2) * m(2, 1);
+    const double c01 = m(1, 2) * m(2, 0) - m(1, 0) * m(2, 2);
+    const double c02 = m(1, 0) * m(2, 1) - m(1, 1) * m(2, 0);
+    const double det = m(0, 0) * c00 + m(0, 1) * c01 + m(0, 2) * c02;
+    if (det == 0) {
+        throw std::invalid_argument("received noninversible matrix");
+    }
+    const double invDet = 1.0 / det;
+
+    Matrix4 result;
+    result(0, 0) = c00 * invDet;
+    result(0, 1) = (m(0, 2) * m(2, 1) - m(0, 1) * m(2, 2)) * invDet;
+    result(0, 2) = (m(0, 1) * m(1, 2) - m(0, 2) * m(1, 1)) * invDet;
+    result(1, 0) = c01 * invDet;
+    result(1, 1) = (m(0, 0) * m(2, 2) - m(0, 2) * m(2, 0)) * invDet;
+    result(1, 2) = (m(0, 2) * m(1, 0) - m(0, 0) * m(1, 2)) * invDet;
+    result(2, 0) = c02 * invDet;
+    result(2, 1) = (m(0, 1) * m(2, 0) - m(0, 0) * m(2, 1)) * invDet;
+    result(2, 2) = (m(0, 0) * m(1, 1) - m(0, 1) * m(1, 0)) * invDet;
+
+    for (int i = 0; i < 3; i++) {
+        result(i, 3) = -(result(i, 0) * m(0, 3) + result(i, 1) * m(1, 3) + result(i, 2) * m(2, 3));
+    }
+    result(3, 3) = 1.0;
+    return result;
+}
+
+constexpr Matrix4 Matrix4::inverse(const Matrix4 &m)
+{
+    if (isAffine(m)) {
+        return affineInverse(m);
+    }
+
+    const double s0 = m(0, 0) * m(1, 1) - m(1, 0) * m(0, 1);
+    const double s1 = m(0, 0) * m(1, 2) - m(1, 0) * m(0, 2);
+    const double s2 = m(0, 0) * m(1, 3) - m(1, 0) * m(0, 3);
+    const double s3 = m(0, 1) * m(1, 2) - m(1, 1) * m(0, 2);
+    const double s4 = m(0, 1) * m(1, 3) - m(1, 1) * m(0, 3);
+    const double s5 = m(0, 2) * m(1, 3) - m(1, 2) * m(0, 3);
+
+    const double c5 = m(2, 2) * m(3, 3) - m(3, 2) * m(2, 3);
+    const double c4 = m(2, 1) * m(3, 3) - m(3, 1) * m(2, 3);
+    const double c3 = m(2, 1) * m(3, 2) - m(3, 1) * m(2, 2);
+    const double c2 = m(2, 0) * m(3, 3) - m(3, 0) * m(2, 3);
+    const double c1 = m(2, 0) * m(3, 2) - m(3, 0) * m(2, 2);
+    const double c0 = m(2, 0) * m(3, 1) - m(3, 0) * m(2, 1);
+
+    const double det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0) {
+        throw std::invalid_argument("received noninversible matrix");
+    }
+    const double invDet = 1.0 / det;
+
+    Matrix4 result;
+    result(0, 0) = ( m(1, 1) * c5 - m(1, 2) * c4 + m(1, 3) * c3) * invDet;
+    result(0, 1) = (-m(0, 1) * c5 + m(0, 2) * c4 - m(0, 3) * c3) * invDet;
+    result(0, 2) = ( m(3, 1) * s5 - m(3, 2) * s4 + m(3, 3) * s3) * invDet;
+    result(0, 3) = (-m(2, 1) * s5 + m(2, 2) * s4 - m(2, 3) * s3) * invDet;
+
+    result(1, 0) = (-m(1, 0) * c5 + m(1, 2) * c2 - m(1, 3) * c1) * invDet;
+    result(1, 1) = ( m(0, 0) * c5 - m(0, 2) * c2 + m(0, 3) * c1) * invDet;
+    result(1, 2) = (-m(3, 0) * s5 + m(3, 2) * s2 - m(3, 3) * s1) * invDet;
+    result(1, 3) = ( m(2, 0) * s5 - m(2, 2) * s2 + m(2, 3) * s1) * invDet;
+
+    result(2, 0) = ( m(1, 0) * c4 - m(1, 1) * c2 + m(1, 3) * c0) * invDet;
+    result(2, 1) = (-m(0, 0) * c4 + m(0, 1) * c2 - m(0, 3) * c0) * invDet;
+    result(2, 2) = ( m(3, 0) * s4 - m(3, 1) * s2 + m(3, 3) * s0) * invDet;
+    result(2, 3) = (-m(2, 0) * s4 + m(2, 1) * s2 - m(2, 3) * s0) * invDet;
+
+    result(3, 0) = (-m(1, 0) * c3 + m(1, 1) * c1 - m(1, 2) * c0) * invDet;
+    result(3, 1) = ( m(0, 0) * c3 - m(0, 1) * c1 + m(0, 2) * c0) * invDet;
+    result(3, 2) = (-m(3, 0) * s3 + m(3, 1) * s1 - m(3, 2) * s0) * invDet;
+    result(3, 3) = ( m(2, 0) * s3 - m(2, 1) * s1 + m(2, 2) * s0) * invDet;
+    return result;
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include <Shapes/TriangleMesh.h>
+#include <istream>
+#include <string>
+
+// Reads the geometry of Wavefront OBJ files: v, vt, vn and f statements. Polygons are split into triangle fans
+// and everything else (groups, materials, smoothing) is ignored. Malformed input throws std::invalid_argument.
+namespace OBJParser {
+    MeshData parseOBJ(std::istream &input);
+    std::shared_ptr<TriangleMesh> meshFromFile(std::string inputPath);
+}
@@ -1,6 +1,6 @@
 #pragma once
 #include <Tuple.h>
-#include <Matrix.h>
+#include <Matrix4.h>
 
 class Ray {
 public:
@@ -10,5 +10,5 @@ public:
     Ray(const Tuple &o, const Tuple &d);
 
     static Tuple position(const Ray &r, double t);
-    static Ray transform(const Ray &r, const Matrix &m);
+    static Ray transform(const Ray &r, const Matrix4 &m);
 };
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include <Ray.h>
+#include <Matrix4.h>
+#include <Intersection.h>
+
+// Up to MAX_SIZE coherent rays stored as structure of arrays. The packet kernels walk the lanes in plain loops
+// over contiguous arrays, which the compiler turns into SSE/AVX code.
+struct RayPacket {
+    static const int MAX_SIZE = 16;
+
+    int size;
+    alignas(64) Real originX[MAX_SIZE];
+    alignas(64) Real originY[MAX_SIZE];
+    alignas(64) Real originZ[MAX_SIZE];
+    alignas(64) Real directionX[MAX_SIZE];
+    alignas(64) Real directionY[MAX_SIZE];
+    alignas(64) Real directionZ[MAX_SIZE];
+    // 1 / direction per axis, for slab tests against bounding boxes.
+    alignas(64) Real inverseX[MAX_SIZE];
+    alignas(64) Real inverseY[MAX_SIZE];
+    alignas(64) Real inverseZ[MAX_SIZE];
+
+    RayPacket();
+
+    // Throws std::invalid_argument once the packet is full.
+    void add(const Ray &r);
+    Ray getRay(int lane) const;
+
+    static RayPacket transform(const RayPacket &p, const Matrix4 &m);
+};
+
+// Closest hit in front of the origin for every lane of a packet, object is nullptr for lanes that hit nothing.
+struct PacketHits {
+    alignas(64) double t[RayPacket::MAX_SIZE];
+    const Shape* object[RayPacket::MAX_SIZE];
+    int primitive[RayPacket::MAX_SIZE];
+    double u[RayPacket::MAX_SIZE];
+    double v[RayPacket::MAX_SIZE];
+
+    PacketHits();
+
+    // Keeps the hit when it is in front of the ray origin and closer than the one the lane already has.
+    void record(int lane, const Intersection &i)
+    {
+        if (i.getT() > 0 && i.getT() < t[lane]) {
+            t[lane] = i.getT();
+            object[lane] = i.getObject();
+            primitive[lane] = i.getPrimitive();
+            u[lane] = i.getU();
+            v[lane] = i.getV();
+        }
+    }
+
+    void record(int lane, double hitT, const Shape *hitObject)
+    {
+        if (hitT > 0 && hitT < t[lane]) {
+            t[lane] = hitT;
+            object[lane] = hitObject;
+            primitive[lane] = -1;
+        }
+    }
+
+    Intersection getIntersection(int lane) const;
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+// Scalar type of Tuple and Color. Define RAYMOND_SINGLE_PRECISION in every project of the solution to render in float,
+// which halves the size of tuples, colors, rays and the canvas. The README lists the accuracy this costs.
+#ifdef RAYMOND_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+
+struct RenderSettings {
+    // 0 means one worker per hardware thread.
+    int threadCount = 0;
+    int tileSize = 16;
+    // Primary rays traced together as one packet: 1 traces every ray alone, otherwise 4, 8 or 16.
+    int packetSize = 8;
+    // Renders coarse blocks first and refines them pass by pass.
+    bool progressive = false;
+    // Engine::renderToFile hands every finished tile to the output file instead of keeping the whole image,
+    // for resolutions that don't fit in memory. Works for .png, .pfm and .exr, not together with progressive.
+    bool streamOutput = false;
+    // Wall-clock budget in seconds, 0 means no limit. Once it runs out the image is returned as far as it got.
+    double timeLimit = 0;
+    // Adaptive anti-aliasing is on when more than one sample per pixel is allowed. Pixels start with a few samples
+    // and keep doubling them while any color channel varies by more than contrastThreshold between them.
+    int maxSamples = 1;
+    double contrastThreshold = 0.05;
+    // Directory of the scene cache, which keeps meshes with their BVH and decoded textures between runs. Empty turns it off.
+    std::string cacheDirectory;
+    // Engine::renderToFile prints the render statistics and, given a path, writes them there as JSON.
+    bool printStats = false;
+    std::string statsPath;
+    // Prints the share of tiles rendered so far to stdout.
+    bool reportProgress = true;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <ostream>
+#include <string>
+
+// Counters and stage timings of a render. Every thread counts into its own instance, which is added to
+// the process-wide totals when the thread exits, so the hot paths never share a cache line.
+struct RenderStats {
+    // Rays by type. Primary rays include the extra samples anti-aliasing took.
+    long long primaryRays = 0;
+    long long shadowRays = 0;
+    long long reflectionRays = 0;
+    long long refractionRays = 0;
+    // Secondary rays Russian roulette dropped instead of tracing them.
+    long long terminatedRays = 0;
+    // Samples anti-aliasing took beyond the initial ones of each pixel, and the number of pixels that needed them.
+    long long extraSamples = 0;
+    long long refinedPixels = 0;
+
+    // Ray-shape intersection tests by shape type, a packet kernel counts one test per lane.
+    long long sphereTests = 0;
+    long long planeTests = 0;
+    long long cubeTests = 0;
+    long long meshTests = 0;
+    long long triangleTests = 0;
+    long long instanceTests = 0;
+
+    long long bvhNodeVisits = 0;
+    long long prepareHitCalls = 0;
+
+    // Wall-clock seconds summed over threads, only measured while timing is enabled.
+    // shadeHit is the direct lighting of every hit, without its secondary rays. It includes lighting, which includes texture lookups.
+    double shadeHitSeconds = 0;
+    double lightingSeconds = 0;
+    double textureSeconds = 0;
+    double imageIOSeconds = 0;
+
+    void merge(const RenderStats &other);
+    void print(std::ostream &out) const;
+    std::string toJSON() const;
+
+    // Counters of the calling thread.
+    static RenderStats& local();
+    // Totals of the threads that have exited since the last reset() plus the calling thread's counters.
+    static RenderStats collect();
+    // Clears the totals and the calling thread's counters, threads that are still running keep theirs.
+    static void reset();
+
+    static void setTimingEnabled(bool enabled);
+    static bool isTimingEnabled();
+};
+
+namespace RenderStatsDetail {
+    // Hands the counters of a thread over to the totals when the thread exits.
+    struct ThreadStats {
+        RenderStats stats;
+        ~ThreadStats();
+    };
+}
+
+// Inline so counting on the hot paths is a plain thread-local increment.
+inline RenderStats& RenderStats::local()
+{
+    static thread_local RenderStatsDetail::ThreadStats instance;
+    return instance.stats;
+}
+
+// Adds the time until the end of the scope to one of the calling thread's stage timings, when timing is enabled.
+class StageTimer {
+public:
+    explicit StageTimer(double RenderStats::*stage, bool active = true);
+    ~StageTimer();
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer& operator=(const StageTimer &) = delete;
+
+private:
+    double RenderStats::*stage;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
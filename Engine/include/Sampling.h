@@ -0,0 +1,37 @@
+#pragma once
+#include <Tuple.h>
+#include <cstdint>
+
+// Random and low-discrepancy numbers for everything the renderer samples.
+namespace Sampling {
+    // PCG32 (O'Neill 2014): 64 bits of state, 32 bits of output per step. Cheap to seed and to copy,
+    // so a generator can be created on the spot from a hash, and every thread owns its own.
+    class Pcg32 {
+    public:
+        explicit Pcg32(uint64_t seed, uint64_t stream = 0);
+
+        uint32_t next();
+        // Uniform in [0, 1).
+        double nextDouble();
+
+        // Generator of the calling thread, seeded differently for every thread.
+        static Pcg32& threadLocal();
+
+    private:
+        uint64_t state;
+        uint64_t increment;
+    };
+
+    // Halton sequence: the digits of index in the given base mirrored around the radix point.
+    // Whatever prefix of it is taken, the points spread evenly over [0, 1).
+    double radicalInverse(int base, uint32_t index);
+    // Dimension 0 or 1 of the Sobol sequence. Together they form a (0, 2)-sequence: every power-of-two prefix puts
+    // exactly one point into each cell of any power-of-two grid over the unit square.
+    // Throws std::invalid_argument for other dimensions.
+    double sobol(int dimension, uint32_t index);
+    // The same point after an Owen scramble, a random permutation of every binary digit given the ones above it.
+    // Each seed gives another sequence with the same stratification and less error than the plain one.
+    double scrambledSobol(int dimension, uint32_t index, uint32_t seed);
+    // Mixes the bits of a point into a seed, so every call with the same point gets the same random numbers.
+    uint64_t hash(const Tuple &point);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <Shapes/TriangleMesh.h>
+#include <Texture/UVImage.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Binary copies of the scene assets that take longest to prepare: meshes together with their BVH, and textures decoded
+// into their compact mip chain. An entry is named after the content hash of its source file, so editing the source
+// leaves the old entry unused and the next load writes a new one. Entries are memory mapped and copied straight into
+// place when read. Stale entries are never removed, deleting the directory clears the cache.
+namespace SceneCache {
+    // 64-bit FNV-1a of the file contents. Throws std::invalid_argument when the file can't be read.
+    uint64_t hashFile(const std::string &path);
+
+    // Same as OBJParser::meshFromFile and ImageIOInterface::textureFromImage, but reads the result from
+    // cacheDirectory when it holds an entry for the current contents of the source, and writes one there otherwise.
+    // The directory is created when missing, when it can't be written the result is returned without an entry.
+    // An empty cacheDirectory turns the cache off.
+    std::shared_ptr<TriangleMesh> loadMesh(const std::string &objPath, const std::string &cacheDirectory);
+    std::shared_ptr<UVImage> loadTexture(const std::string &imagePath, const std::string &cacheDirectory);
+}
@@ -5,5 +5,6 @@
 
 namespace SceneParser {
 	Camera getCameraFromSceneJSON(nlohmann::json sceneJson);
-	World getWorldFromSceneJSON(nlohmann::json sceneJson);
+	// Meshes and texture images go through SceneCache when cacheDirectory is not empty.
+	World getWorldFromSceneJSON(nlohmann::json sceneJson, const std::string &cacheDirectory = "");
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <Shapes/Shape.h>
+#include <memory>
+
+// Places a shared prototype shape somewhere else in the world. The prototype's geometry, acceleration structure
+// and material are referenced, not copied, so an instance only costs its transform.
+class Instance : public Shape, public std::enable_shared_from_this<Instance> {
+public:
+    // The prototype's own transform is read here, set it before creating instances of it.
+    static std::shared_ptr<Instance> createInstance(const std::shared_ptr<Shape> &prototype);
+
+    bool operator==(const Shape &other) const override;
+
+    // m places the prototype, getTransform() returns m combined with the prototype's transform,
+    // which maps the prototype's object space to the world like the transform of any other shape.
+    void setTransform(const Matrix4 &m) override;
+    const Matrix4& getTransform() const override;
+    const Matrix4& getInverseTransform() const override;
+    const Matrix4& getPlacement() const;
+
+    // The material belongs to the prototype, changing it changes every instance.
+    void setMaterial(const Material &m) override;
+    Material& getMaterial() override;
+    const Material& getMaterial() const override;
+
+    Tuple normalAt(const Tuple &point) const override;
+    Tuple normalAt(const Tuple &point, const Intersection &hit) const override;
+    // The prototype's coordinates, with the scale corrected by the average stretch of the placement.
+    std::optional<SurfaceUV> surfaceUVAt(const Intersection &hit) const override;
+    Bounds getBounds() const override;
+    using Shape::intersects;
+    void intersects(const Ray &r, std::vector<Intersection> &result) const override;
+    void intersectsToHit(const Ray &r, std::vector<Intersection> &result) const override;
+    bool occludes(const Ray &r, double maxT) const override;
+
+    std::shared_ptr<const Shape> getPrototype() const;
+
+private:
+    std::shared_ptr<Shape> prototype;
+    Matrix4 placement;
+    Matrix4 inversePlacement;
+    Matrix4 placementNormalTransform;
+    Matrix4 transform;
+    Matrix4 inverseTransform;
+
+    explicit Instance(const std::shared_ptr<Shape> &prototype);
+
+    Tuple toWorldNormal(const Tuple &prototypeNormal) const;
+    // Hits from result[first] on were found on the prototype, they belong to this instance.
+    void claimHits(std::vector<Intersection> &result, size_t first) const;
+};
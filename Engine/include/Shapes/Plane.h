@@ -8,20 +8,25 @@ public:
 
     bool operator==(const Shape &other) const override;
 
-    void setTransform(const Matrix &m) override;
-    Matrix getTransform() const override;
-    Matrix getInverseTransform() const override;
+    void setTransform(const Matrix4 &m) override;
+    const Matrix4& getTransform() const override;
+    const Matrix4& getInverseTransform() const override;
 
     void setMaterial(const Material &m) override;
     Material& getMaterial() override;
-    Material getMaterial() const override;
+    const Material& getMaterial() const override;
 
     Tuple normalAt(const Tuple &point) const override;
-    std::vector<Intersection> intersects(const Ray &r) const override;
+    Bounds getBounds() const override;
+    using Shape::intersects;
+    void intersects(const Ray &r, std::vector<Intersection> &result) const override;
+    void intersects(const RayPacket &packet, PacketHits &hits) const override;
 
 private:
-    Matrix transform;
-    Matrix inverseTransform;
+    Matrix4 transform;
+    Matrix4 inverseTransform;
+    // The normal is the same everywhere on a plane, so it is transformed once in setTransform().
+    Tuple worldNormal;
     Material material;
 
     Plane();
@@ -1,19 +1,40 @@
 #pragma once
-#include <Matrix.h>
+#include <Matrix4.h>
 #include <Material.h>
 #include <Intersection.h>
 #include <Ray.h>
+#include <RayPacket.h>
+#include <Bounds.h>
+#include <optional>
 #include <vector>
 
 class Shape {
 public:
     virtual bool operator==(const Shape &other) const = 0;
-    virtual void setTransform(const Matrix &m) = 0;
-    virtual Matrix getTransform() const = 0;
-    virtual Matrix getInverseTransform() const = 0;
+    virtual void setTransform(const Matrix4 &m) = 0;
+    virtual const Matrix4& getTransform() const = 0;
+    virtual const Matrix4& getInverseTransform() const = 0;
     virtual void setMaterial(const Material &m) = 0;
     virtual Material& getMaterial() = 0;
-    virtual Material getMaterial() const = 0;
+    // Shading reads the material of every hit through this, so it must not copy.
+    virtual const Material& getMaterial() const = 0;
     virtual Tuple normalAt(const Tuple &point) const = 0;
-    virtual std::vector<Intersection> intersects(const Ray &r) const = 0;
+    // Shapes made of several primitives need to know which one was hit, the rest only look at the point.
+    virtual Tuple normalAt(const Tuple &point, const Intersection &hit) const;
+    // Texture coordinates of the shape at the hit, which take the place of the texture's mapping. Nothing by default.
+    virtual std::optional<SurfaceUV> surfaceUVAt(const Intersection &hit) const;
+    // Bounds in object space, infinite for unbounded shapes such as planes.
+    virtual Bounds getBounds() const = 0;
+    // Appends the intersections with r to result without clearing it, so one buffer can collect a whole world.
+    virtual void intersects(const Ray &r, std::vector<Intersection> &result) const = 0;
+    std::vector<Intersection> intersects(const Ray &r) const;
+    // Like intersects(), but hits past the closest one in front of the origin may be left out. Shapes made of many
+    // primitives stop looking once nothing closer remains, the default appends every hit.
+    virtual void intersectsToHit(const Ray &r, std::vector<Intersection> &result) const;
+    // Whether r hits the shape somewhere in (0, maxT), for shadow rays. The default scans every intersection,
+    // shapes made of many primitives override it to stop at the first one in range.
+    virtual bool occludes(const Ray &r, double maxT) const;
+    // Records the closest hit in front of each ray of the packet. The default goes ray by ray,
+    // shapes with a packet kernel override it.
+    virtual void intersects(const RayPacket &packet, PacketHits &hits) const;
 };
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+#include <Shapes/Shape.h>
+#include <BVH.h>
+#include <Texture/UVMapping.h>
+#include <memory>
+
+// Mesh geometry in flat arrays. Triangles index into them per corner, so vertices shared between faces are stored once.
+struct MeshData {
+    // x, y, z per vertex.
+    std::vector<double> positions;
+    // x, y, z per vertex normal, may be empty.
+    std::vector<double> normals;
+    // u, v per texture coordinate, may be empty.
+    std::vector<double> uvs;
+    // Three entries per triangle. Normal and uv indices are -1 for corners without them.
+    std::vector<int> positionIndices;
+    std::vector<int> normalIndices;
+    std::vector<int> uvIndices;
+
+    int getTriangleCount() const;
+};
+
+class TriangleMesh : public Shape, public std::enable_shared_from_this<TriangleMesh> {
+public:
+    // Throws std::invalid_argument when a triangle refers past the end of the arrays.
+    static std::shared_ptr<TriangleMesh> createTriangleMesh(MeshData data);
+    // Skips building the BVH and uses one built over the same triangles before, e.g. by the scene cache.
+    // Also throws std::invalid_argument when the BVH doesn't index exactly the triangles of the mesh.
+    static std::shared_ptr<TriangleMesh> createTriangleMesh(MeshData data, BVH bvh);
+
+    bool operator==(const Shape &other) const override;
+
+    void setTransform(const Matrix4 &m) override;
+    const Matrix4& getTransform() const override;
+    const Matrix4& getInverseTransform() const override;
+
+    void setMaterial(const Material &m) override;
+    Material& getMaterial() override;
+    const Material& getMaterial() const override;
+
+    // Without the hit there is no way to tell which triangle the point lies on, so this throws std::invalid_argument.
+    Tuple normalAt(const Tuple &point) const override;
+    // Interpolates the vertex normals of the hit triangle, or uses its face normal when the mesh has none.
+    Tuple normalAt(const Tuple &point, const Intersection &hit) const override;
+    Bounds getBounds() const override;
+    using Shape::intersects;
+    void intersects(const Ray &r, std::vector<Intersection> &result) const override;
+    // Hits behind the origin are all kept for the refraction containers, in front of it the BVH traversal stops at
+    // the closest hit found so far.
+    void intersectsToHit(const Ray &r, std::vector<Intersection> &result) const override;
+    // Traverses the BVH over [0, maxT] only and returns at the first triangle in between.
+    bool occludes(const Ray &r, double maxT) const override;
+
+    int getTriangleCount() const;
+    const MeshData& getData() const;
+    const BVH& getBVH() const;
+    // Texture coordinates interpolated at the hit, (0, 0) when the mesh has none.
+    UV uvAt(const Intersection &hit) const;
+    // uvAt() for shading, nothing when the hit triangle has no texture coordinates.
+    std::optional<SurfaceUV> surfaceUVAt(const Intersection &hit) const override;
+
+private:
+    struct Geometry {
+        MeshData data;
+        BVH bvh;
+    };
+
+    // Shared between copies of the mesh, the geometry never changes once built.
+    std::shared_ptr<const Geometry> geometry;
+    Matrix4 transform;
+    Matrix4 inverseTransform;
+    Matrix4 normalTransform;
+    Material material;
+
+    explicit TriangleMesh(std::shared_ptr<const Geometry> geometry);
+
+    void intersectTriangles(const Ray &r, bool untilHit, std::vector<Intersection> &result) const;
+    // Tests the triangles the BVH finds along the object space ray within [tMin, tMax].
+    // onHit(triangle, t, u, v, tMax) may shrink tMax, returning true ends the traversal.
+    template <typename OnHit>
+    void traverseTriangles(const Ray &ray, double tMin, double &tMax, OnHit onHit) const;
+    Tuple vertex(int triangle, int corner) const;
+    Tuple faceNormal(int triangle) const;
+};
@@ -6,4 +6,8 @@ class Pattern {
 public:
     Color intensity;
     virtual Color atUV(const UV &uv) const = 0;
+    // Filtered lookup over a footprint given as a width in uv units. Only called when usesFootprint() is true,
+    // working out the footprint costs extra mapping evaluations.
+    virtual Color atUV(const UV &uv, double /*footprint*/) const { return atUV(uv); }
+    virtual bool usesFootprint() const { return false; }
 };
\ No newline at end of file
@@ -1,5 +1,5 @@
 #pragma once
-#include <Matrix.h>
+#include <Matrix4.h>
 #include <Color.h>
 #include <Texture/Pattern.h>
 #include <Texture/UVMapping.h>
@@ -12,13 +12,16 @@ public:
     Texture(std::shared_ptr<Pattern> texture, std::shared_ptr<UVMapping> mapping);
     static std::shared_ptr<Texture> createTexture(std::shared_ptr<Pattern> texture, std::shared_ptr<UVMapping> mapping);
 
-    void setTransform(const Matrix &m);
-    Matrix getTransform() const;
-    Matrix getInverseTransform() const;
+    void setTransform(const Matrix4 &m);
+    Matrix4 getTransform() const;
+    Matrix4 getInverseTransform() const;
 
-    Color atObject(const Matrix &inverseObjectTransform, const Tuple &point) const;
+    // footprint is the width of the surface around point that the lookup stands for, 0 looks up a single point.
+    Color atObject(const Matrix4 &inverseObjectTransform, const Tuple &point, double footprint = 0) const;
+    // Looks up coordinates the shape carries itself, the mapping and the texture transform don't apply to them.
+    Color atSurface(const SurfaceUV &surface, double footprint = 0) const;
 
 private:
-    Matrix transform;
-    Matrix inverseTransform;
+    Matrix4 transform;
+    Matrix4 inverseTransform;
 };
\ No newline at end of file
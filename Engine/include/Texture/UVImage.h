@@ -1,13 +1,63 @@
 #pragma once
 #include <Texture/Pattern.h>
 #include <Canvas.h>
+#include <cstdint>
+#include <vector>
 
+// Image texture with a mip chain, stored compactly: 8 bits per channel when every pixel of the source is a multiple of
+// 1/255 in [0, 1], which is what 8-bit image files decode to, half floats otherwise. Each level is laid out in tiles of
+// TILE_SIZE x TILE_SIZE texels, so the texels of a filtered lookup share a few cache lines at any texture width.
+// Texel centers sit at (x + 0.5) / width and v runs from the bottom of the image up, lookups clamp at the edges.
 class UVImage : public Pattern, public std::enable_shared_from_this<UVImage> {
 public:
-    std::shared_ptr<Canvas> image;
+    enum class Format : uint32_t { UNORM8 = 1, HALF = 2 };
 
-    UVImage(std::shared_ptr<Canvas> canvas);
+    static const int TILE_SIZE = 8;
+
+    explicit UVImage(const Canvas &canvas);
+    // From 8-bit RGB rows the way image files decode, without the float canvas in between.
+    UVImage(int width, int height, const uint8_t *rgb);
     static std::shared_ptr<UVImage> createUVImage(std::shared_ptr<Canvas> canvas);
+    // Takes texels previously returned by getTexels() of an image of the same size and format, e.g. from the
+    // scene cache. Throws std::invalid_argument when their size doesn't match.
+    static std::shared_ptr<UVImage> createUVImage(int width, int height, Format format, std::vector<uint8_t> texels);
 
+    // Bilinear lookup in the full resolution level.
     Color atUV(const UV &uv) const override;
-};
\ No newline at end of file
+    // Trilinear lookup: bilinear in the two levels whose texels are closest to the footprint, blended by how close.
+    Color atUV(const UV &uv, double footprint) const override;
+    bool usesFootprint() const override;
+
+    int getWidth() const;
+    int getHeight() const;
+    Format getFormat() const;
+    // Levels halve the size of the previous one, rounding down, until the last one is 1 x 1.
+    int getLevelCount() const;
+    int getLevelWidth(int level) const;
+    int getLevelHeight(int level) const;
+    Color texel(int level, int x, int y) const;
+    // Every level in its tiled layout, the way createUVImage() takes them back.
+    const std::vector<uint8_t>& getTexels() const;
+
+private:
+    struct Level {
+        int width, height;
+        int tilesX;
+        // Index of the level's first texel.
+        size_t offset;
+    };
+
+    Format format;
+    std::vector<Level> levels;
+    std::vector<uint8_t> texels;
+
+    UVImage(int width, int height, Format format);
+
+    // Stores the full resolution level from fetch(x, y, rgb) and filters the others down from it.
+    template <typename Fetch>
+    void build(Fetch fetch);
+
+    size_t texelIndex(const Level &level, int x, int y) const;
+    void store(const Level &level, int x, int y, const float *rgb);
+    Color bilinear(int level, const UV &uv) const;
+};
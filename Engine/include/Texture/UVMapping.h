@@ -9,6 +9,13 @@ struct UV {
     bool operator==(const UV& other) const;
 };
 
+// Texture coordinates a shape carries itself, e.g. from the vt records of an OBJ file, and how fast they change:
+// uv units per unit of distance in the world.
+struct SurfaceUV {
+    UV uv;
+    double scale;
+};
+
 class UVMapping {
 public:
     UVMapping() {};
@@ -1,30 +1,128 @@
 #pragma once
+#include <Real.h>
 #include <array>
+#include <cmath>
 
+// Point or vector in homogeneous coordinates. Everything is inline, so the arithmetic of the hot loops in other
+// translation units is visible to the optimizer, and the four components are aligned to load as one vector.
 class Tuple {
 public:
-    Tuple(double x, double y, double z, double w);
+    constexpr Tuple(Real x, Real y, Real z, Real w) : values{ x, y, z, w } {}
 
-    static Tuple point(double x, double y, double z);
-    static Tuple vector(double x, double y, double z);
-    static bool isPoint(const Tuple &tuple);
-    static bool isVector(const Tuple &tuple);
+    static constexpr Tuple point(Real x, Real y, Real z);
+    static constexpr Tuple vector(Real x, Real y, Real z);
+    static constexpr bool isPoint(const Tuple &tuple);
+    static constexpr bool isVector(const Tuple &tuple);
     
-    double& operator[] (int x);
-    double operator[] (int x) const;
-    bool operator==(const Tuple &other) const;
-    Tuple operator+(const Tuple &other) const;
-    Tuple operator*(double scalar) const;
-    Tuple operator/(double scalar) const;
-    Tuple operator-(const Tuple &other) const;
-    Tuple operator-() const;
-
-    static double magnitude(const Tuple &tuple);
+    constexpr Real& operator[] (int x) { return values[x]; }
+    constexpr Real operator[] (int x) const { return values[x]; }
+    constexpr bool operator==(const Tuple &other) const;
+    constexpr Tuple operator+(const Tuple &other) const;
+    constexpr Tuple operator*(Real scalar) const;
+    constexpr Tuple operator/(Real scalar) const;
+    constexpr Tuple operator-(const Tuple &other) const;
+    constexpr Tuple operator-() const;
+
+    static Real magnitude(const Tuple &tuple);
     static Tuple normalize(const Tuple &tuple);
-    static double dot(const Tuple &t1, const Tuple &t2);
-    static Tuple cross(const Tuple &t1, const Tuple &t2);
-    static Tuple reflect(const Tuple &in, const Tuple &normal);
+    static constexpr Real dot(const Tuple &t1, const Tuple &t2);
+    static constexpr Tuple cross(const Tuple &t1, const Tuple &t2);
+    static constexpr Tuple reflect(const Tuple &in, const Tuple &normal);
 
 private:
-    std::array<double, 4> values;
+    static constexpr Real EPSILON = Real(0.00001);
+
+    alignas(4 * sizeof(Real)) std::array<Real, 4> values;
 };
+
+constexpr Tuple Tuple::point(Real x, Real y, Real z)
+{
+    return Tuple(x, y, z, 1);
+}
+
+constexpr Tuple Tuple::vector(Real x, Real y, Real z)
+{
+    return Tuple(x, y, z, 0);
+}
+
+constexpr bool Tuple::isPoint(const Tuple &tuple)
+{
+    return tuple.values[3] - 1 < EPSILON && tuple.values[3] - 1 > -EPSILON;
+}
+
+constexpr bool Tuple::isVector(const Tuple &tuple)
+{
+    return tuple.values[3] < EPSILON && tuple.values[3] > -EPSILON;
+}
+
+constexpr bool Tuple::operator==(const Tuple &other) const
+{
+    for (int i = 0; i < 4; i++) {
+        const Real difference = values[i] - other.values[i];
+        if (difference >= EPSILON || difference <= -EPSILON) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr Tuple Tuple::operator+(const Tuple &other) const
+{
+    return Tuple(values[0] + other.values[0],
+        values[1] + other.values[1],
+        values[2] + other.values[2],
+        values[3] + other.values[3]);
+}
+
+constexpr Tuple Tuple::operator*(Real scalar) const
+{
+    return Tuple(values[0] * scalar, values[1] * scalar, values[2] * scalar, values[3] * scalar);
+}
+
+constexpr Tuple Tuple::operator/(Real scalar) const
+{
+    return Tuple(values[0] / scalar, values[1] / scalar, values[2] / scalar, values[3] / scalar);
+}
+
+constexpr Tuple Tuple::operator-(const Tuple &other) const
+{
+    return Tuple(values[0] - other.values[0],
+        values[1] - other.values[1],
+        values[2] - other.values[2],
+        values[3] - other.values[3]);
+}
+
+constexpr Tuple Tuple::operator-() const
+{
+    return Tuple(-values[0], -values[1], -values[2], -values[3]);
+}
+
+inline Real Tuple::magnitude(const Tuple &tuple)
+{
+    return std::sqrt(dot(tuple, tuple));
+}
+
+inline Tuple Tuple::normalize(const Tuple &tuple)
+{
+    return tuple / magnitude(tuple);
+}
+
+constexpr Real Tuple::dot(const Tuple &t1, const Tuple &t2)
+{
+    return t1.values[0] * t2.values[0]
+        + t1.values[1] * t2.values[1]
+        + t1.values[2] * t2.values[2]
+        + t1.values[3] * t2.values[3];
+}
+
+constexpr Tuple Tuple::cross(const Tuple &t1, const Tuple &t2)
+{
+    return vector(t1.values[1] * t2.values[2] - t1.values[2] * t2.values[1],
+        t1.values[2] * t2.values[0] - t1.values[0] * t2.values[2],
+        t1.values[0] * t2.values[1] - t1.values[1] * t2.values[0]);
+}
+
+constexpr Tuple Tuple::reflect(const Tuple &in, const Tuple &normal)
+{
+    return in - normal * 2 * dot(in, normal);
+}
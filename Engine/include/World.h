@@ -4,12 +4,16 @@
 #include <Shapes/Shape.h>
 #include <Intersection.h>
 #include <Hit.h>
+#include <BVH.h>
+#include <RayPacket.h>
+#include <RenderStats.h>
 #include <vector>
 
 
 class World {
 public:
-    static const int MAX_REFLECTION_BOUNCES = 4;
+    // Default bounce limit of reflection and refraction rays.
+    static constexpr int MAX_REFLECTION_BOUNCES = 4;
 
     World();
     static World makeDefaultWorld();
@@ -21,22 +25,90 @@ public:
     PointLight getPointLight(int index) const;
     AreaLight& getAreaLight(int index);
     AreaLight getAreaLight(int index) const;
+    // Scenes with many lights can shade every point with just count of them. They are picked with probability
+    // proportional to an estimate of their contribution and weighted to keep the expected color unchanged.
+    // 0, or at least as many as there are lights, shades with every light.
+    void setLightSamples(int count);
+    int getLightSamples() const;
+    // How many reflections and refractions a camera ray may go through, MAX_REFLECTION_BOUNCES unless the scene says otherwise.
+    void setMaxBounces(int bounces);
+    int getMaxBounces() const;
+    // Secondary rays whose weight, the share of their color in the pixel, falls below the threshold play Russian roulette:
+    // they survive with probability weight / threshold and then count with the threshold as their weight, which keeps
+    // the expected color unchanged. 0 traces every ray.
+    void setRouletteThreshold(double threshold);
+    double getRouletteThreshold() const;
+    // Width a pixel covers per unit of distance along a camera ray, usually Camera::pixelSize. Texture lookups are
+    // filtered over the footprint this gives at the hit, with the distance summed over reflections and refractions.
+    // 0 samples textures at full resolution.
+    void setPixelSpread(double spread);
+    double getPixelSpread() const;
 
     int getObjectCount() const;
     void addObject(const std::shared_ptr<Shape> &object);
     std::shared_ptr<Shape> getObject(int index) const;
 
+    // Builds a BVH over the world-space bounds of the objects, unbounded shapes are kept aside and tested linearly.
+    // Objects moved after this call are not picked up until it is called again, adding an object drops the structure.
+    void buildAccelerationStructure();
+    bool hasAccelerationStructure() const;
+
     std::vector<Intersection> intersects(const Ray &r) const;
-    Color shadeHit(Hit hit, int remainingBounces) const;
+    // Sorted intersections up to and including the closest hit, which is all prepareHit() needs.
+    std::vector<Intersection> intersectsToHit(const Ray &r) const;
+    // Overloads that clear and refill a caller-owned buffer, so a reused buffer makes the query allocation free.
+    void intersects(const Ray &r, std::vector<Intersection> &result) const;
+    void intersectsToHit(const Ray &r, std::vector<Intersection> &result) const;
+    // Closest hit of every ray in the packet, hits must start out empty.
+    void intersects(const RayPacket &packet, PacketHits &hits) const;
+    Color shadeHit(const Hit &hit, int remainingBounces) const;
     bool isShadowed(const Tuple &lightPosition, const Tuple &point) const;
+    // Any-hit query for shadow rays: true as soon as some shape blocks r in (0, maxT), nothing gets sorted.
+    bool occluded(const Ray &r, double maxT) const;
     double intensityAt(const PointLight &light, const Tuple &point) const;
     double intensityAt(const AreaLight &light, const Tuple &point) const;
-    Color reflectedColor(Hit hit, int remainingBounces) const;
-    Color refractedColor(Hit hit, int remainingBounces) const;
-    Color colorAt(const Ray& r, int remainingBounces = MAX_REFLECTION_BOUNCES) const;
+    Color reflectedColor(const Hit &hit, int remainingBounces) const;
+    Color refractedColor(const Hit &hit, int remainingBounces) const;
+    // Secondary rays are not traced recursively. Every reflection and refraction goes into a queue with the weight
+    // its color contributes to the result, and the queue is traced one generation of bounces after the other.
+    Color colorAt(const Ray &r) const;
+    Color colorAt(const Ray &r, int remainingBounces) const;
+    // Same for the lanes of a packet. Each generation of secondary rays is traced in packets as well.
+    void colorAt(const RayPacket &packet, Color *result) const;
+    void colorAt(const RayPacket &packet, Color *result, int remainingBounces) const;
 
 private:
+    // A ray waiting to be traced, the color it finds is added to result[pixel] scaled by weight.
+    struct QueuedRay {
+        Ray ray;
+        Color weight;
+        int pixel;
+        int remainingBounces;
+        // Distance travelled from the camera to the origin of the ray.
+        double distance;
+    };
+
     std::vector<PointLight> pointLights;
     std::vector<AreaLight> areaLights;
+    int lightSamples;
+    int maxBounces;
+    double rouletteThreshold;
+    double pixelSpread;
     std::vector<std::shared_ptr<Shape>> objects;
+
+    bool accelerated;
+    BVH bvh;
+    std::vector<std::shared_ptr<Shape>> boundedObjects;
+    std::vector<std::shared_ptr<Shape>> unboundedObjects;
+
+    // Direct light at the hit, without reflections and refractions. distance is how far the ray had come before it.
+    Color surfaceColor(const Hit &hit, double distance) const;
+    Color sampledLighting(const Hit &hit, const Material &material, double footprint, const std::optional<SurfaceUV> &surfaceUV) const;
+    void queueSecondaryRays(const Hit &hit, const Color &weight, int pixel, int remainingBounces, double distance, std::vector<QueuedRay> &queue) const;
+    // Traces the queue and every ray spawned from it, then leaves it empty. Rays of one generation are traced
+    // together, in packets when packets is set.
+    void trace(std::vector<QueuedRay> &queue, Color *result, bool packets) const;
+    // Per-thread buffers for the rays trace() has yet to follow, 0 for the current generation of bounces and 1 for the next.
+    static std::vector<QueuedRay>& scratchQueue(int generation);
+    void collectIntersections(const Ray &r, bool untilHit, std::vector<Intersection> &result) const;
 };
\ No newline at end of file
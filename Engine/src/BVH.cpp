@@ -0,0 +1,178 @@
+#include <BVH.h>
+#include <algorithm>
+#include <math.h>
+#include <stdexcept>
+#include <utility>
+
+static const int BIN_COUNT = 12;
+static const double TRAVERSAL_COST = 1.0;
+static const double INTERSECTION_COST = 1.0;
+// Past this depth nodes are split at the median so the traversal stack stays bounded. Median splits halve the
+// primitives, so they add at most 31 levels for an int count and the tree stays within MAX_DEPTH.
+static const int MAX_SAH_DEPTH = 32;
+
+BVH::BVH()
+{
+}
+
+BVH::BVH(std::vector<BVHNode> nodes, std::vector<int> primitiveIndices) :
+    nodes(std::move(nodes)), primitiveIndices(std::move(primitiveIndices))
+{
+    const int nodeCount = static_cast<int>(this->nodes.size());
+    const int indexCount = static_cast<int>(this->primitiveIndices.size());
+    for (int i = 0; i < nodeCount; i++) {
+        const BVHNode &node = this->nodes[i];
+        const bool valid = node.isLeaf()
+            ? node.offset >= 0 && node.count <= indexCount - node.offset
+            : node.offset > i + 1 && node.offset < nodeCount && i + 1 < nodeCount && node.axis >= 0 && node.axis < 3;
+        if (!valid) {
+            throw std::invalid_argument("BVH node out of range");
+        }
+    }
+
+    // Children always come after their parent, so one backwards pass finds the interior nodes below every node.
+    std::vector<int> depths(nodeCount, 0);
+    for (int i = nodeCount - 1; i >= 0; i--) {
+        const BVHNode &node = this->nodes[i];
+        if (!node.isLeaf()) {
+            depths[i] = 1 + std::max(depths[i + 1], depths[node.offset]);
+            if (depths[i] > MAX_DEPTH) {
+                throw std::invalid_argument("BVH deeper than the traversal stack");
+            }
+        }
+    }
+}
+
+BVH::BVH(const std::vector<Bounds>& primitiveBounds)
+{
+    if (primitiveBounds.empty()) {
+        return;
+    }
+
+    std::vector<Tuple> centroids;
+    centroids.reserve(primitiveBounds.size());
+    primitiveIndices.reserve(primitiveBounds.size());
+    for (int i = 0; i < static_cast<int>(primitiveBounds.size()); i++) {
+        centroids.push_back(primitiveBounds[i].centroid());
+        primitiveIndices.push_back(i);
+    }
+
+    nodes.reserve(2 * primitiveBounds.size());
+    build(primitiveBounds, centroids, 0, static_cast<int>(primitiveBounds.size()), 0);
+}
+
+bool BVH::isEmpty() const
+{
+    return nodes.empty();
+}
+
+const std::vector<BVHNode>& BVH::getNodes() const
+{
+    return nodes;
+}
+
+const std::vector<int>& BVH::getPrimitiveIndices() const
+{
+    return primitiveIndices;
+}
+
+Bounds BVH::getBounds() const
+{
+    return nodes.empty() ? Bounds() : nodes[0].bounds;
+}
+
+int BVH::build(const std::vector<Bounds>& primitiveBounds, const std::vector<Tuple>& centroids, int begin, int end, int depth)
+{
+    int nodeIndex = static_cast<int>(nodes.size());
+    nodes.push_back(BVHNode{ Bounds(), begin, end - begin, 0 });
+
+    Bounds bounds, centroidBounds;
+    for (int i = begin; i < end; i++) {
+        bounds.extend(primitiveBounds[primitiveIndices[i]]);
+        centroidBounds.extend(centroids[primitiveIndices[i]]);
+    }
+    nodes[nodeIndex].bounds = bounds;
+
+    int count = end - begin;
+    if (count <= 1) {
+        return nodeIndex;
+    }
+
+    int axis = centroidBounds.largestAxis();
+    double axisMin = centroidBounds.min[axis];
+    double axisExtent = centroidBounds.max[axis] - axisMin;
+    if (axisExtent <= 0.0 || depth >= MAX_SAH_DEPTH) {
+        if (count <= MAX_LEAF_SIZE) {
+            return nodeIndex;
+        }
+        int middle = begin + count / 2;
+        std::nth_element(primitiveIndices.data() + begin, primitiveIndices.data() + middle, primitiveIndices.data() + end,
+            [&](int a, int b) { return centroids[a][axis] < centroids[b][axis]; });
+        return split(primitiveBounds, centroids, nodeIndex, axis, begin, middle, end, depth);
+    }
+
+    auto binOf = [&](int primitive) {
+        int bin = static_cast<int>(BIN_COUNT * (centroids[primitive][axis] - axisMin) / axisExtent);
+        return std::min(bin, BIN_COUNT - 1);
+    };
+
+    Bounds binBounds[BIN_COUNT];
+    int binCounts[BIN_COUNT] = { 0 };
+    for (int i = begin; i < end; i++) {
+        int bin = binOf(primitiveIndices[i]);
+        binCounts[bin]++;
+        binBounds[bin].extend(primitiveBounds[primitiveIndices[i]]);
+    }
+
+    // Sweep from the right to know the cost of everything past each split plane.
+    double rightArea[BIN_COUNT];
+    int rightCount[BIN_COUNT];
+    Bounds accumulated;
+    int accumulatedCount = 0;
+    for (int bin = BIN_COUNT - 1; bin > 0; bin--) {
+        accumulated.extend(binBounds[bin]);
+        accumulatedCount += binCounts[bin];
+        rightArea[bin] = accumulated.surfaceArea();
+        rightCount[bin] = accumulatedCount;
+    }
+
+    double parentArea = std::max(bounds.surfaceArea(), 1e-12);
+    double bestCost = INFINITY;
+    int bestSplit = -1;
+    accumulated = Bounds();
+    accumulatedCount = 0;
+    for (int candidate = 1; candidate < BIN_COUNT; candidate++) {
+        accumulated.extend(binBounds[candidate - 1]);
+        accumulatedCount += binCounts[candidate - 1];
+        if (accumulatedCount == 0 || rightCount[candidate] == 0) {
+            continue;
+        }
+        double cost = TRAVERSAL_COST + INTERSECTION_COST *
+            (accumulated.surfaceArea() * accumulatedCount + rightArea[candidate] * rightCount[candidate]) / parentArea;
+        if (cost < bestCost) {
+            bestCost = cost;
+            bestSplit = candidate;
+        }
+    }
+
+    double leafCost = INTERSECTION_COST * count;
+    if (bestSplit < 0 || (count <= MAX_LEAF_SIZE && bestCost >= leafCost)) {
+        return nodeIndex;
+    }
+
+    int* middlePointer = std::partition(primitiveIndices.data() + begin, primitiveIndices.data() + end,
+        [&](int primitive) { return binOf(primitive) < bestSplit; });
+    int middle = static_cast<int>(middlePointer - primitiveIndices.data());
+
+    return split(primitiveBounds, centroids, nodeIndex, axis, begin, middle, end, depth);
+}
+
+int BVH::split(const std::vector<Bounds>& primitiveBounds, const std::vector<Tuple>& centroids, int nodeIndex, int axis, int begin, int middle, int end, int depth)
+{
+    nodes[nodeIndex].axis = axis;
+    nodes[nodeIndex].count = 0;
+    build(primitiveBounds, centroids, begin, middle, depth + 1);
+    int secondChild = build(primitiveBounds, centroids, middle, end, depth + 1);
+    nodes[nodeIndex].offset = secondChild;
+    return nodeIndex;
+}
@@ -0,0 +1,143 @@
+#include <Bounds.h>
+#include <algorithm>
+#include <limits>
+#include <math.h>
+
+static const double INF = std::numeric_limits<double>::infinity();
+
+Bounds::Bounds() : min(Tuple::point(INF, INF, INF)), max(Tuple::point(-INF, -INF, -INF))
+{
+}
+
+Bounds::Bounds(const Tuple & min, const Tuple & max) : min(min), max(max)
+{
+}
+
+Bounds Bounds::infinite()
+{
+    return Bounds(Tuple::point(-INF, -INF, -INF), Tuple::point(INF, INF, INF));
+}
+
+bool Bounds::isEmpty() const
+{
+    return min[0] > max[0] || min[1] > max[1] || min[2] > max[2];
+}
+
+bool Bounds::isInfinite() const
+{
+    for (int i = 0; i < 3; i++) {
+        if (isinf(min[i]) || isinf(max[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Bounds::extend(const Tuple & point)
+{
+    for (int i = 0; i < 3; i++) {
+        min[i] = std::min(min[i], point[i]);
+        max[i] = std::max(max[i], point[i]);
+    }
+}
+
+void Bounds::extend(const Bounds & other)
+{
+    if (other.isEmpty()) {
+        return;
+    }
+    extend(other.min);
+    extend(other.max);
+}
+
+Tuple Bounds::centroid() const
+{
+    return Tuple::point((min[0] + max[0]) * 0.5, (min[1] + max[1]) * 0.5, (min[2] + max[2]) * 0.5);
+}
+
+double Bounds::surfaceArea() const
+{
+    if (isEmpty()) {
+        return 0.0;
+    }
+    double dx = max[0] - min[0];
+    double dy = max[1] - min[1];
+    double dz = max[2] - min[2];
+    return 2.0 * (dx * dy + dy * dz + dz * dx);
+}
+
+int Bounds::largestAxis() const
+{
+    double dx = max[0] - min[0];
+    double dy = max[1] - min[1];
+    double dz = max[2] - min[2];
+    if (dx >= dy && dx >= dz) {
+        return 0;
+    }
+    return dy >= dz ? 1 : 2;
+}
+
+bool Bounds::intersects(const Ray & r, const Tuple & inverseDirection, double tMin, double tMax, double & tEntry, double & tExit) const
+{
+    for (int axis = 0; axis < 3; axis++) {
+        double t0 = (min[axis] - r.origin[axis]) * inverseDirection[axis];
+        double t1 = (max[axis] - r.origin[axis]) * inverseDirection[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        // A ray running exactly along a slab face gives 0 * inf, treat it as inside that slab.
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+        if (tMin > tMax) {
+            return false;
+        }
+    }
+    tEntry = tMin;
+    tExit = tMax;
+    return true;
+}
+
+bool Bounds::intersects(const RayPacket & packet, const double * tMax) const
+{
+    bool any = false;
+    for (int i = 0; i < packet.size; i++) {
+        double tx0 = (min[0] - packet.originX[i]) * packet.inverseX[i];
+        double tx1 = (max[0] - packet.originX[i]) * packet.inverseX[i];
+        double ty0 = (min[1] - packet.originY[i]) * packet.inverseY[i];
+        double ty1 = (max[1] - packet.originY[i]) * packet.inverseY[i];
+        double tz0 = (min[2] - packet.originZ[i]) * packet.inverseZ[i];
+        double tz1 = (max[2] - packet.originZ[i]) * packet.inverseZ[i];
+
+        double entry = 0.0;
+        double exit = tMax[i];
+        entry = std::min(tx0, tx1) > entry ? std::min(tx0, tx1) : entry;
+        exit = std::max(tx0, tx1) < exit ? std::max(tx0, tx1) : exit;
+        entry = std::min(ty0, ty1) > entry ? std::min(ty0, ty1) : entry;
+        exit = std::max(ty0, ty1) < exit ? std::max(ty0, ty1) : exit;
+        entry = std::min(tz0, tz1) > entry ? std::min(tz0, tz1) : entry;
+        exit = std::max(tz0, tz1) < exit ? std::max(tz0, tz1) : exit;
+        any |= entry <= exit;
+    }
+    return any;
+}
+
+Bounds Bounds::transform(const Bounds & b, const Matrix4 & m)
+{
+    if (b.isEmpty() || b.isInfinite()) {
+        return b.isEmpty() ? b : infinite();
+    }
+
+    Bounds result;
+    for (int corner = 0; corner < 8; corner++) {
+        Tuple point = Tuple::point(corner & 1 ? b.max[0] : b.min[0],
+                                   corner & 2 ? b.max[1] : b.min[1],
+                                   corner & 4 ? b.max[2] : b.min[2]);
+        result.extend(m * point);
+    }
+    return result;
+}
+
+Tuple Bounds::inverseDirection(const Ray & r)
+{
+    return Tuple::vector(1.0 / r.direction[0], 1.0 / r.direction[1], 1.0 / r.direction[2]);
+}
@@ -1,6 +1,14 @@
 #include <Camera.h>
+#include <Sampling.h>
+#include <ThreadPool.h>
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <stdexcept>
 
 Camera Camera::makeCamera(int hSize, int vSize, double fov)
 {
@@ -17,24 +25,29 @@ Camera Camera::makeCamera(int hSize, int vSize, double fov)
         halfHeight = halfView;
     }
     double pixelSize = (halfWidth * 2) / hSize;
-    return Camera(hSize, vSize, fov, pixelSize, Matrix::getIdentity4x4(), halfWidth, halfHeight);
+    return Camera(hSize, vSize, fov, pixelSize, Matrix4::identity(), halfWidth, halfHeight);
 }
 
-void Camera::setTransform(const Matrix& m)
+void Camera::setTransform(const Matrix4& m)
 {
     transform = m;
-    inverseTransform = Matrix::inverse(transform);
+    inverseTransform = Matrix4::inverse(transform);
 }
 
-Matrix Camera::getTransform() const
+Matrix4 Camera::getTransform() const
 {
     return transform;
 }
 
-Ray Camera::rayForPixel(int px, int py)
+Ray Camera::rayForPixel(int px, int py) const
 {
-    double xOffset = (px + 0.5) * pixelSize;
-    double yOffset = (py + 0.5) * pixelSize;
+    return rayForPixel(px, py, 0.5, 0.5);
+}
+
+Ray Camera::rayForPixel(int px, int py, double offsetX, double offsetY) const
+{
+    double xOffset = (px + offsetX) * pixelSize;
+    double yOffset = (py + offsetY) * pixelSize;
 
     double worldX = halfWidth - xOffset;
     double worldY = halfHeight - yOffset;
@@ -46,21 +59,353 @@ Ray Camera::rayForPixel(int px, int py)
     return Ray(origin, direction);
 }
 
-Canvas Camera::render(World w)
+namespace {
+
+// Wall-clock budget of a render, 0 seconds means none. Once it has passed it stays passed.
+class Deadline {
+public:
+    explicit Deadline(double seconds) : limited(seconds > 0), expired(false),
+        end(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds)))
+    {
+    }
+
+    bool passed()
+    {
+        if (limited && !expired && std::chrono::steady_clock::now() >= end) {
+            expired = true;
+        }
+        return expired.load();
+    }
+
+private:
+    const bool limited;
+    std::atomic<bool> expired;
+    const std::chrono::steady_clock::time_point end;
+};
+
+// Prints the share of finished tasks to stdout whenever it reaches another percent.
+class Progress {
+public:
+    Progress(int totalTasks, bool enabled) : totalTasks(totalTasks), enabled(enabled), doneTasks(0), reportedPercent(-1)
+    {
+    }
+
+    void taskDone()
+    {
+        int percent = (++doneTasks * 100) / totalTasks;
+        if (!enabled) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (percent > reportedPercent) {
+            reportedPercent = percent;
+            std::cout << "Rendered " << percent << "%\n";
+        }
+    }
+
+private:
+    const int totalTasks;
+    const bool enabled;
+    std::atomic<int> doneTasks;
+    std::mutex mutex;
+    int reportedPercent;
+};
+
+// First exception thrown by a render task. Pool threads have nowhere to report it, so it is kept and rethrown on the
+// thread that started the render once the pool is idle. Tasks that start after it skip their work.
+class TaskError {
+public:
+    template <typename Task>
+    void guard(Task task)
+    {
+        if (occurred()) {
+            return;
+        }
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed = true;
+        }
+    }
+
+    bool occurred() const
+    {
+        return failed.load();
+    }
+
+    void rethrow()
+    {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    std::mutex mutex;
+    std::exception_ptr error;
+    std::atomic<bool> failed{ false };
+};
+
+}
+
+static void checkPacketSize(int packetSize)
 {
+    if (packetSize != 1 && packetSize != 4 && packetSize != 8 && packetSize != 16) {
+        throw std::invalid_argument("packet size must be 1, 4, 8 or 16");
+    }
+}
+
+Canvas Camera::render(const World &w, const RenderSettings &settings, const std::function<void(const Canvas&)> &onPass) const
+{
+    checkPacketSize(settings.packetSize);
+
     Canvas image = Canvas(hSize, vSize);
-    for (int y = 0; y < vSize; y++) {
-        for (int x = 0; x < hSize; x++) {
-            Ray ray = rayForPixel(x, y);
-            Color color = w.colorAt(ray);
-            image.set(x, y, color);
+    const int tileSize = std::max(1, settings.tileSize);
+    const int tilesX = (hSize + tileSize - 1) / tileSize;
+    const int tilesY = (vSize + tileSize - 1) / tileSize;
+    const int tileCount = tilesX * tilesY;
+
+    // Progressive passes halve the block size each time, starting from the largest power of two that fits a tile.
+    std::vector<int> steps;
+    if (settings.progressive) {
+        int step = 1;
+        while (step * 2 <= std::min(tileSize, MAX_PROGRESSIVE_STEP)) {
+            step *= 2;
+        }
+        for (; step >= 1; step /= 2) {
+            steps.push_back(step);
+        }
+    }
+    else {
+        steps.push_back(1);
+    }
+
+    Deadline deadline(settings.timeLimit);
+    auto outOfTime = [&]() { return deadline.passed(); };
+    Progress progress(tileCount * static_cast<int>(steps.size()), settings.reportProgress);
+
+    TaskError error;
+    ThreadPool pool(settings.threadCount);
+    for (size_t pass = 0; pass < steps.size(); pass++) {
+        const int step = steps[pass];
+        const bool refining = pass > 0;
+
+        for (int tile = 0; tile < tileCount; tile++) {
+            pool.submit([&, tile, step, refining]() {
+                if (outOfTime()) {
+                    return;
+                }
+
+                error.guard([&]() {
+                    const int x0 = (tile % tilesX) * tileSize;
+                    const int y0 = (tile / tilesX) * tileSize;
+                    const int x1 = std::min(x0 + tileSize, hSize);
+                    const int y1 = std::min(y0 + tileSize, vSize);
+                    renderTile(w, image, 0, 0, x0, y0, x1, y1, step, refining, settings, outOfTime);
+                });
+
+                progress.taskDone();
+            });
+        }
+        pool.wait();
+        error.rethrow();
+
+        if (outOfTime()) {
+            std::cout << "Time limit reached during pass " << pass + 1 << " of " << steps.size() << "\n";
+            break;
+        }
+        if (onPass && pass + 1 < steps.size()) {
+            onPass(image);
         }
-        std::cout << "Rendered row " << y << std::endl;
     }
+    std::cout << std::flush;
+
     return image;
 }
 
-Camera::Camera(int hSize, int vSize, double fov, double pixelSize, const Matrix &m, double halfWidth, double halfHeight) : hSize(hSize), vSize(vSize), fieldOfView(fov),
-pixelSize(pixelSize), transform(m), inverseTransform(Matrix::inverse(m)), halfWidth(halfWidth), halfHeight(halfHeight)
+void Camera::renderTiles(const World &w, const RenderSettings &settings, const std::function<void(const Canvas&, int, int)> &onTile) const
+{
+    checkPacketSize(settings.packetSize);
+
+    const int tileSize = std::max(1, settings.tileSize);
+    const int tilesX = (hSize + tileSize - 1) / tileSize;
+    const int tilesY = (vSize + tileSize - 1) / tileSize;
+    const int tileCount = tilesX * tilesY;
+
+    Deadline deadline(settings.timeLimit);
+    auto outOfTime = [&]() { return deadline.passed(); };
+    Progress progress(tileCount, settings.reportProgress);
+    std::mutex outputMutex;
+    // Errors of onTile too, e.g. from an image writer, end the render and reach the caller.
+    TaskError error;
+
+    // Every worker takes the next tile in reading order, so the tiles in flight stay within a few tile rows
+    // and a writer that needs the rows in order only holds those.
+    std::atomic<int> nextTile(0);
+    ThreadPool pool(settings.threadCount);
+    for (int worker = 0; worker < pool.getThreadCount(); worker++) {
+        pool.submit([&]() {
+            error.guard([&]() {
+                for (int tile = nextTile++; tile < tileCount && !error.occurred(); tile = nextTile++) {
+                    const int x0 = (tile % tilesX) * tileSize;
+                    const int y0 = (tile / tilesX) * tileSize;
+                    const int x1 = std::min(x0 + tileSize, hSize);
+                    const int y1 = std::min(y0 + tileSize, vSize);
+
+                    // Past the time limit tiles stay black, the output still gets all of them.
+                    Canvas image = Canvas(x1 - x0, y1 - y0);
+                    if (!outOfTime()) {
+                        renderTile(w, image, x0, y0, x0, y0, x1, y1, 1, false, settings, outOfTime);
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(outputMutex);
+                        onTile(image, x0, y0);
+                    }
+                    progress.taskDone();
+                }
+            });
+        });
+    }
+    pool.wait();
+    error.rethrow();
+
+    if (outOfTime()) {
+        std::cout << "Time limit reached\n";
+    }
+    std::cout << std::flush;
+}
+
+void Camera::renderTile(const World &w, Canvas &image, int originX, int originY, int x0, int y0, int x1, int y1, int step, bool refining,
+    const RenderSettings &settings, const std::function<bool()> &outOfTime) const
+{
+    RenderStats &stats = RenderStats::local();
+    if (step == 1 && settings.maxSamples > 1) {
+        // Anti-aliased pixels replace the center samples of earlier passes rather than keeping them.
+        for (int y = y0; y < y1; y++) {
+            if (outOfTime()) {
+                return;
+            }
+            for (int x = x0; x < x1; x++) {
+                image.set(x - originX, y - originY, renderPixel(w, x, y, settings));
+            }
+        }
+        return;
+    }
+
+    const int packetSize = settings.packetSize;
+    // Packets cover small square-ish blocks of samples so their rays stay coherent.
+    const int packetWidth = packetSize == 4 ? 2 : (packetSize == 1 ? 1 : 4);
+    const int packetHeight = packetSize / packetWidth;
+    const int blockWidth = packetWidth * step;
+    const int blockHeight = packetHeight * step;
+
+    auto traced = [&](int x, int y) {
+        // Samples on the grid of the previous pass are already in the image.
+        return refining && (x - x0) % (2 * step) == 0 && (y - y0) % (2 * step) == 0;
+    };
+    auto fill = [&](int x, int y, const Color &color) {
+        for (int fy = y; fy < std::min(y + step, y1); fy++) {
+            for (int fx = x; fx < std::min(x + step, x1); fx++) {
+                image.set(fx - originX, fy - originY, color);
+            }
+        }
+    };
+
+    int xs[RayPacket::MAX_SIZE], ys[RayPacket::MAX_SIZE];
+    Color colors[RayPacket::MAX_SIZE];
+    for (int by = y0; by < y1; by += blockHeight) {
+        if (outOfTime()) {
+            return;
+        }
+        for (int bx = x0; bx < x1; bx += blockWidth) {
+            if (packetSize == 1) {
+                if (!traced(bx, by)) {
+                    fill(bx, by, w.colorAt(rayForPixel(bx, by)));
+                    stats.primaryRays++;
+                }
+                continue;
+            }
+
+            RayPacket packet;
+            for (int y = by; y < std::min(by + blockHeight, y1); y += step) {
+                for (int x = bx; x < std::min(bx + blockWidth, x1); x += step) {
+                    if (!traced(x, y)) {
+                        xs[packet.size] = x;
+                        ys[packet.size] = y;
+                        packet.add(rayForPixel(x, y));
+                    }
+                }
+            }
+
+            w.colorAt(packet, colors);
+            for (int lane = 0; lane < packet.size; lane++) {
+                fill(xs[lane], ys[lane], colors[lane]);
+            }
+            stats.primaryRays += packet.size;
+        }
+    }
+}
+
+Color Camera::renderPixel(const World &w, int px, int py, const RenderSettings &settings) const
+{
+    const int maxSamples = settings.maxSamples;
+    const int initialSamples = std::min(INITIAL_SAMPLES, maxSamples);
+    Color colors[RayPacket::MAX_SIZE];
+
+    Color sum = Color(0, 0, 0);
+    Color lowest = Color(INFINITY, INFINITY, INFINITY);
+    Color highest = Color(-INFINITY, -INFINITY, -INFINITY);
+    int count = 0;
+    int batch = initialSamples;
+
+    while (true) {
+        // Halton index 0 is the pixel corner, the sequence starts at 1.
+        for (int first = count; first < count + batch; first += settings.packetSize) {
+            const int last = std::min(first + settings.packetSize, count + batch);
+            if (settings.packetSize == 1) {
+                for (int i = first; i < last; i++) {
+                    colors[i - first] = w.colorAt(rayForPixel(px, py, Sampling::radicalInverse(2, i + 1), Sampling::radicalInverse(3, i + 1)));
+                }
+            }
+            else {
+                RayPacket packet;
+                for (int i = first; i < last; i++) {
+                    packet.add(rayForPixel(px, py, Sampling::radicalInverse(2, i + 1), Sampling::radicalInverse(3, i + 1)));
+                }
+                w.colorAt(packet, colors);
+            }
+
+            for (int i = 0; i < last - first; i++) {
+                const Color &c = colors[i];
+                sum = sum + c;
+                lowest = Color(std::min(lowest.red, c.red), std::min(lowest.green, c.green), std::min(lowest.blue, c.blue));
+                highest = Color(std::max(highest.red, c.red), std::max(highest.green, c.green), std::max(highest.blue, c.blue));
+            }
+        }
+        count += batch;
+
+        const double contrast = std::max({ highest.red - lowest.red, highest.green - lowest.green, highest.blue - lowest.blue });
+        if (count >= maxSamples || contrast <= settings.contrastThreshold) {
+            break;
+        }
+        batch = std::min(count, maxSamples - count);
+    }
+
+    RenderStats &stats = RenderStats::local();
+    stats.primaryRays += count;
+    if (count > initialSamples) {
+        stats.extraSamples += count - initialSamples;
+        stats.refinedPixels++;
+    }
+    return sum / count;
+}
+
+Camera::Camera(int hSize, int vSize, double fov, double pixelSize, const Matrix4 &m, double halfWidth, double halfHeight) : hSize(hSize), vSize(vSize), fieldOfView(fov),
+pixelSize(pixelSize), transform(m), inverseTransform(Matrix4::inverse(m)), halfWidth(halfWidth), halfHeight(halfHeight)
 {
 }
\ No newline at end of file
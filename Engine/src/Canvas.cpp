@@ -2,15 +2,29 @@
 #include <algorithm>
 
 Canvas::Canvas(int w, int h) : width(w) , height(h) {
-    grid = std::unique_ptr<Color[]>(new Color[w * h]);
+    pixels = std::unique_ptr<float[]>(new float[3 * w * h]());
 }
 
 Color Canvas::at(int x, int y) const
 {
-    return grid[y * width + x];
+    const float *pixel = &pixels[3 * (y * width + x)];
+    return Color(pixel[0], pixel[1], pixel[2]);
 }
 
 void Canvas::set(int x, int y, Color color)
 {
-    grid[y * width + x] = color;
-}
\ No newline at end of file
+    float *pixel = &pixels[3 * (y * width + x)];
+    pixel[0] = static_cast<float>(color.red);
+    pixel[1] = static_cast<float>(color.green);
+    pixel[2] = static_cast<float>(color.blue);
+}
+
+const float* Canvas::data() const
+{
+    return pixels.get();
+}
+
+float* Canvas::data()
+{
+    return pixels.get();
+}
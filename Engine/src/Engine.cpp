@@ -1,17 +1,80 @@
 #include <Engine.h>
 #include <SceneParser.h>
 #include <ImageIOInterface.h>
+#include <RenderStats.h>
 
 #include <fstream>
+#include <iostream>
+#include <stdexcept>
 
-void Engine::renderToFile(std::string scenePath, std::string outputPath)
+void Engine::renderToFile(std::string scenePath, std::string outputPath, const RenderSettings &settings)
 {
+	if (!ImageIOInterface::isSupportedFormat(outputPath))
+	{
+		throw std::invalid_argument("Unsupported image format: " + outputPath);
+	}
+	if (settings.streamOutput && !ImageIOInterface::isStreamableFormat(outputPath))
+	{
+		throw std::invalid_argument("Streamed output needs a .png, .pfm or .exr file: " + outputPath);
+	}
+	if (settings.streamOutput && settings.progressive)
+	{
+		throw std::invalid_argument("Streamed output can't be combined with progressive rendering");
+	}
+
+	const bool collectStats = settings.printStats || !settings.statsPath.empty();
+	RenderStats::reset();
+	RenderStats::setTimingEnabled(collectStats);
+
 	std::ifstream ifs(scenePath);
 	nlohmann::json sceneJson = nlohmann::json::parse(ifs);
 
 	Camera camera = SceneParser::getCameraFromSceneJSON(sceneJson);
-	World world = SceneParser::getWorldFromSceneJSON(sceneJson);
+	World world = SceneParser::getWorldFromSceneJSON(sceneJson, settings.cacheDirectory);
+	world.setPixelSpread(camera.pixelSize);
+	world.buildAccelerationStructure();
+
+	if (settings.streamOutput)
+	{
+		std::unique_ptr<ImageIOInterface::TileWriter> writer = ImageIOInterface::openTileWriter(outputPath, camera.hSize, camera.vSize);
+		camera.renderTiles(world, settings, [&](const Canvas &tile, int x, int y) {
+			StageTimer timer(&RenderStats::imageIOSeconds);
+			writer->write(tile, x, y);
+		});
+		StageTimer timer(&RenderStats::imageIOSeconds);
+		writer->finish();
+	}
+	else
+	{
+		// Progressive renders overwrite the output with a preview after every pass.
+		Canvas image = camera.render(world, settings, [&](const Canvas &preview) {
+			ImageIOInterface::saveToImage(preview, outputPath);
+		});
+		ImageIOInterface::saveToImage(image, outputPath);
+	}
+
+	RenderStats stats = RenderStats::collect();
+	// The full statistics below already report the extra samples.
+	if (settings.maxSamples > 1 && !settings.printStats)
+	{
+		const long long pixels = (long long) camera.hSize * camera.vSize;
+		std::cout << "Anti-aliasing: " << stats.extraSamples << " extra samples on " << stats.refinedPixels << " of " << pixels
+			<< " pixels, " << (double) stats.primaryRays / pixels << " samples per pixel on average" << std::endl;
+	}
+
+	if (settings.printStats)
+	{
+		stats.print(std::cout);
+		std::cout << std::flush;
+	}
 
-	Canvas image = camera.render(world);
-	ImageIOInterface::saveToImage(image, outputPath);
+	if (!settings.statsPath.empty())
+	{
+		std::ofstream statsFile(settings.statsPath);
+		if (!statsFile)
+		{
+			throw std::invalid_argument("Could not write the statistics to: " + settings.statsPath);
+		}
+		statsFile << stats.toJSON() << std::endl;
+	}
 }
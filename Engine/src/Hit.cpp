@@ -7,7 +7,7 @@ Hit::Hit(const Intersection & i, const bool ins, const Tuple & p, const Tuple &
 {
 }
 
-double Hit::schlick()
+double Hit::schlick() const
 {
     double cos = Tuple::dot(eyev, normalv);
     if (n1 > n2)
@@ -1,38 +1,452 @@
 #include <ImageIOInterface.h>
+#include <RenderStats.h>
+#include <Texture/UVImage.h>
 #include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <vector>
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include <stdexcept>
 
-void ImageIOInterface::saveToImage(const Canvas& canvas, std::string outputPath)
+static std::vector<uint8_t> toBytes(const Canvas &canvas)
+{
+    const float *data = canvas.data();
+    std::vector<uint8_t> pixels(3 * canvas.width * canvas.height);
+    for (size_t i = 0; i < pixels.size(); i++)
+    {
+        pixels[i] = (uint8_t)round(255.0 * std::clamp<double>(data[i], 0.0, 1.0));
+    }
+    return pixels;
+}
+
+template <typename T>
+static void put(std::vector<char> &out, T value)
+{
+    const char *bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static void putBigEndian(std::vector<char> &out, T value)
+{
+    for (int shift = 8 * (sizeof(T) - 1); shift >= 0; shift -= 8)
+    {
+        out.push_back((char)((value >> shift) & 0xff));
+    }
+}
+
+static void putAttribute(std::vector<char> &out, const std::string &name, const std::string &type, const std::vector<char> &value)
+{
+    out.insert(out.end(), name.begin(), name.end());
+    out.push_back(0);
+    out.insert(out.end(), type.begin(), type.end());
+    out.push_back(0);
+    put<int32_t>(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static std::fstream openForWriting(const std::string &path)
+{
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        throw std::invalid_argument("Could not write the image to: " + path);
+    }
+    return file;
+}
+
+static void checkTile(const Canvas &tile, int x, int y, int width, int height)
+{
+    if (x < 0 || y < 0 || x + tile.width > width || y + tile.height > height)
+    {
+        throw std::invalid_argument("Tile lies outside of the image");
+    }
+}
+
+// Portable float map: a text header, then little endian floats row by row from the bottom. Every pixel has a fixed
+// place in the file, so tiles are written straight to it.
+class PFMWriter : public ImageIOInterface::TileWriter {
+public:
+    PFMWriter(const std::string &path, int width, int height) : path(path), width(width), height(height), file(openForWriting(path))
+    {
+        file << "PF\n" << width << " " << height << "\n-1.0\n";
+        pixelsStart = file.tellp();
+    }
+
+    void write(const Canvas &tile, int x, int y) override
+    {
+        checkTile(tile, x, y, width, height);
+        for (int row = 0; row < tile.height; row++)
+        {
+            const std::streamoff line = height - 1 - (y + row);
+            file.seekp(pixelsStart + (line * width + x) * 3 * (std::streamoff)sizeof(float));
+            file.write(reinterpret_cast<const char*>(tile.data() + 3 * row * tile.width), 3 * tile.width * sizeof(float));
+        }
+    }
+
+    void finish() override
+    {
+        file.close();
+        if (file.fail())
+        {
+            throw std::invalid_argument("Could not write the image to: " + path);
+        }
+    }
+
+private:
+    std::string path;
+    int width, height;
+    std::fstream file;
+    std::streamoff pixelsStart;
+};
+
+// Single part scanline OpenEXR without compression, one scanline per block. Every number in the file is little
+// endian, like the machines this builds on. Blocks have a fixed size, so the header, the offset table and the block
+// headers are written up front and tiles go straight to their place.
+class EXRWriter : public ImageIOInterface::TileWriter {
+public:
+    EXRWriter(const std::string &path, int width, int height) : path(path), width(width), height(height), file(openForWriting(path))
+    {
+        std::vector<char> header;
+        put<int32_t>(header, 20000630);
+        put<int32_t>(header, 2);
+
+        // Channels are listed, and stored within a scanline, in alphabetical order. Type 2 is 32-bit float.
+        std::vector<char> channels;
+        for (const char *name : { "B", "G", "R" })
+        {
+            channels.push_back(name[0]);
+            channels.push_back(0);
+            put<int32_t>(channels, 2);
+            put<int32_t>(channels, 0);
+            put<int32_t>(channels, 1);
+            put<int32_t>(channels, 1);
+        }
+        channels.push_back(0);
+        putAttribute(header, "channels", "chlist", channels);
+        putAttribute(header, "compression", "compression", { 0 });
+
+        std::vector<char> window;
+        put<int32_t>(window, 0);
+        put<int32_t>(window, 0);
+        put<int32_t>(window, width - 1);
+        put<int32_t>(window, height - 1);
+        putAttribute(header, "dataWindow", "box2i", window);
+        putAttribute(header, "displayWindow", "box2i", window);
+        putAttribute(header, "lineOrder", "lineOrder", { 0 });
+
+        std::vector<char> value;
+        put<float>(value, 1.0f);
+        putAttribute(header, "pixelAspectRatio", "float", value);
+        value.clear();
+        put<float>(value, 0.0f);
+        put<float>(value, 0.0f);
+        putAttribute(header, "screenWindowCenter", "v2f", value);
+        value.clear();
+        put<float>(value, 1.0f);
+        putAttribute(header, "screenWindowWidth", "float", value);
+        header.push_back(0);
+
+        // The offset table points at every scanline block: its y, its size in bytes, then the pixels channel by channel.
+        lineSize = 3 * width * sizeof(float);
+        firstBlock = header.size() + height * sizeof(uint64_t);
+        for (int y = 0; y < height; y++)
+        {
+            put<uint64_t>(header, blockOffset(y));
+        }
+        file.write(header.data(), header.size());
+
+        for (int y = 0; y < height; y++)
+        {
+            const int32_t blockHeader[2] = { y, lineSize };
+            file.seekp(blockOffset(y));
+            file.write(reinterpret_cast<const char*>(blockHeader), sizeof(blockHeader));
+        }
+    }
+
+    void write(const Canvas &tile, int x, int y) override
+    {
+        checkTile(tile, x, y, width, height);
+        std::vector<float> channel(tile.width);
+        for (int row = 0; row < tile.height; row++)
+        {
+            const float *pixels = tile.data() + 3 * row * tile.width;
+            // B, G and R are the third, second and first float of a pixel.
+            for (int c = 0; c < 3; c++)
+            {
+                for (int i = 0; i < tile.width; i++)
+                {
+                    channel[i] = pixels[3 * i + 2 - c];
+                }
+                file.seekp(blockOffset(y + row) + 2 * sizeof(int32_t) + ((std::streamoff)c * width + x) * sizeof(float));
+                file.write(reinterpret_cast<const char*>(channel.data()), tile.width * sizeof(float));
+            }
+        }
+    }
+
+    void finish() override
+    {
+        file.close();
+        if (file.fail())
+        {
+            throw std::invalid_argument("Could not write the image to: " + path);
+        }
+    }
+
+private:
+    std::string path;
+    int width, height;
+    std::fstream file;
+    int32_t lineSize;
+    uint64_t firstBlock;
+
+    uint64_t blockOffset(int y) const
+    {
+        return firstBlock + y * (2 * sizeof(int32_t) + lineSize);
+    }
+};
+
+static uint32_t crc32(const char *data, size_t size, uint32_t crc = 0)
 {
-    uint8_t* pixels = new uint8_t[canvas.width * canvas.height * 3];
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> result;
+        for (uint32_t n = 0; n < 256; n++)
+        {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++)
+            {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++)
+    {
+        crc = table[(crc ^ (uint8_t)data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+// PNG has to be written top to bottom, so finished rows wait here until all rows above them are written, and only
+// rows of the tiles in flight are ever held. The pixels are stored without compression, zlib stored blocks cost
+// 5 bytes per 64 KB and need no window of past rows.
+class PNGWriter : public ImageIOInterface::TileWriter {
+public:
+    PNGWriter(const std::string &path, int width, int height) : path(path), width(width), height(height), file(openForWriting(path))
+    {
+        static const char signature[8] = { (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+        file.write(signature, sizeof(signature));
+
+        // 8 bits per channel, truecolor, no interlacing.
+        std::vector<char> header;
+        putBigEndian<uint32_t>(header, width);
+        putBigEndian<uint32_t>(header, height);
+        header.insert(header.end(), { 8, 2, 0, 0, 0 });
+        writeChunk("IHDR", header);
 
-    int index = 0;
-    for (int j = 0; j < canvas.height; j++)
+        // zlib header: deflate with a 32 KB window, no preset dictionary, no compression.
+        block = { 0x78, 0x01 };
+    }
+
+    void write(const Canvas &tile, int x, int y) override
+    {
+        checkTile(tile, x, y, width, height);
+        if (y < nextRow)
+        {
+            throw std::invalid_argument("Tile overlaps rows already written");
+        }
+
+        for (int row = 0; row < tile.height; row++)
+        {
+            PendingRow &pending = rows[y + row];
+            if (pending.bytes.empty())
+            {
+                pending.bytes.resize(3 * width);
+            }
+            const float *pixels = tile.data() + 3 * row * tile.width;
+            for (int i = 0; i < 3 * tile.width; i++)
+            {
+                pending.bytes[3 * x + i] = (uint8_t)round(255.0 * std::clamp<double>(pixels[i], 0.0, 1.0));
+            }
+            pending.filled += tile.width;
+        }
+
+        for (auto next = rows.find(nextRow); next != rows.end() && next->second.filled >= width; next = rows.find(nextRow))
+        {
+            // Every row starts with its filter type, 0 leaves the bytes as they are.
+            append(0);
+            for (uint8_t value : next->second.bytes)
+            {
+                append(value);
+            }
+            rows.erase(next);
+            nextRow++;
+        }
+    }
+
+    void finish() override
     {
-        for (int i = 0; i < canvas.width; i++)
+        if (nextRow != height)
         {
-            Color color = canvas.at(i, j);
-            uint8_t r = (int)round(255.0 * std::clamp(color.red, 0.0, 1.0));
-            uint8_t g = (int)round(255.0 * std::clamp(color.green, 0.0, 1.0));
-            uint8_t b = (int)round(255.0 * std::clamp(color.blue, 0.0, 1.0));
+            throw std::invalid_argument("Not every row of the image was written: " + path);
+        }
+        writeBlock(true);
+        writeChunk("IEND", {});
 
-            pixels[index++] = r;
-            pixels[index++] = g;
-            pixels[index++] = b;
+        file.close();
+        if (file.fail())
+        {
+            throw std::invalid_argument("Could not write the image to: " + path);
         }
     }
 
-    stbi_write_jpg(outputPath.c_str(), canvas.width, canvas.height, 3, pixels, 100);
-    delete[] pixels;
+private:
+    static const size_t MAX_STORED_BLOCK = 65535;
+
+    struct PendingRow {
+        std::vector<uint8_t> bytes;
+        int filled = 0;
+    };
+
+    std::string path;
+    int width, height;
+    std::fstream file;
+    std::map<int, PendingRow> rows;
+    int nextRow = 0;
+    // Deflate data of the IDAT chunk being filled, the zlib header goes into the first one.
+    std::vector<char> block;
+    std::vector<uint8_t> stored;
+    uint32_t adlerA = 1, adlerB = 0;
+
+    void append(uint8_t value)
+    {
+        stored.push_back(value);
+        adlerA = (adlerA + value) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+        if (stored.size() == MAX_STORED_BLOCK)
+        {
+            writeBlock(false);
+        }
+    }
+
+    // One stored deflate block per IDAT chunk. The last one ends the zlib stream with its Adler-32 checksum.
+    void writeBlock(bool last)
+    {
+        const uint16_t size = (uint16_t)stored.size();
+        block.push_back(last ? 1 : 0);
+        block.push_back((char)(size & 0xff));
+        block.push_back((char)(size >> 8));
+        block.push_back((char)(~size & 0xff));
+        block.push_back((char)((~size >> 8) & 0xff));
+        block.insert(block.end(), stored.begin(), stored.end());
+        if (last)
+        {
+            putBigEndian<uint32_t>(block, (adlerB << 16) | adlerA);
+        }
+        writeChunk("IDAT", block);
+        block.clear();
+        stored.clear();
+    }
+
+    void writeChunk(const char *type, const std::vector<char> &data)
+    {
+        std::vector<char> chunk;
+        putBigEndian<uint32_t>(chunk, (uint32_t)data.size());
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        putBigEndian<uint32_t>(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+        file.write(chunk.data(), chunk.size());
+    }
+};
+
+static std::string extensionOf(const std::string &path)
+{
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    return extension;
+}
+
+bool ImageIOInterface::isStreamableFormat(const std::string &path)
+{
+    const std::string extension = extensionOf(path);
+    return extension == ".png" || extension == ".pfm" || extension == ".exr";
+}
+
+std::unique_ptr<ImageIOInterface::TileWriter> ImageIOInterface::openTileWriter(const std::string &outputPath, int width, int height)
+{
+    const std::string extension = extensionOf(outputPath);
+    if (extension == ".png")
+    {
+        return std::make_unique<PNGWriter>(outputPath, width, height);
+    }
+    else if (extension == ".pfm")
+    {
+        return std::make_unique<PFMWriter>(outputPath, width, height);
+    }
+    else if (extension == ".exr")
+    {
+        return std::make_unique<EXRWriter>(outputPath, width, height);
+    }
+    throw std::invalid_argument("Unsupported streaming format: " + outputPath);
+}
+
+bool ImageIOInterface::isSupportedFormat(const std::string &path)
+{
+    const std::string extension = extensionOf(path);
+    return extension == ".jpg" || extension == ".jpeg" || extension == ".png"
+        || extension == ".hdr" || extension == ".pfm" || extension == ".exr";
+}
+
+void ImageIOInterface::saveToImage(const Canvas& canvas, std::string outputPath)
+{
+    StageTimer timer(&RenderStats::imageIOSeconds);
+    const std::string extension = extensionOf(outputPath);
+
+    bool written;
+    if (extension == ".jpg" || extension == ".jpeg")
+    {
+        written = stbi_write_jpg(outputPath.c_str(), canvas.width, canvas.height, 3, toBytes(canvas).data(), 100) != 0;
+    }
+    else if (extension == ".png")
+    {
+        written = stbi_write_png(outputPath.c_str(), canvas.width, canvas.height, 3, toBytes(canvas).data(), 3 * canvas.width) != 0;
+    }
+    else if (extension == ".hdr")
+    {
+        written = stbi_write_hdr(outputPath.c_str(), canvas.width, canvas.height, 3, canvas.data()) != 0;
+    }
+    else if (extension == ".pfm" || extension == ".exr")
+    {
+        std::unique_ptr<TileWriter> writer = openTileWriter(outputPath, canvas.width, canvas.height);
+        writer->write(canvas, 0, 0);
+        writer->finish();
+        return;
+    }
+    else
+    {
+        throw std::invalid_argument("Unsupported image format: " + outputPath);
+    }
+
+    if (!written)
+    {
+        throw std::invalid_argument("Could not write the image to: " + outputPath);
+    }
 }
 
 
 Canvas ImageIOInterface::canvasFromImage(std::string inputPath)
 {
+    StageTimer timer(&RenderStats::imageIOSeconds);
     int width, height, channels;
     unsigned char* img = stbi_load(inputPath.c_str(), &width, &height, &channels, STBI_rgb);
 
@@ -53,5 +467,21 @@ Canvas ImageIOInterface::canvasFromImage(std::string inputPath)
 
     stbi_image_free(img);
 
+    return result;
+}
+
+std::shared_ptr<UVImage> ImageIOInterface::textureFromImage(std::string inputPath)
+{
+    StageTimer timer(&RenderStats::imageIOSeconds);
+    int width, height, channels;
+    unsigned char* img = stbi_load(inputPath.c_str(), &width, &height, &channels, STBI_rgb);
+
+    if (img == NULL) {
+        throw std::invalid_argument("Error on loading image: " + inputPath);
+    }
+
+    std::shared_ptr<UVImage> result = std::make_shared<UVImage>(width, height, img);
+    stbi_image_free(img);
+
     return result;
 }
\ No newline at end of file
@@ -1,8 +1,68 @@
 #include <Intersection.h>
 #include <Shapes/Shape.h>
 #include <Hit.h>
+#include <RenderStats.h>
+#include <algorithm>
 
-Intersection::Intersection(double value, const std::shared_ptr<const Shape>& o) : t(value), object(o)
+namespace {
+    // Shapes the ray is inside of, innermost last, keyed by their address. Nesting is shallow in practice,
+    // so they live in a fixed array on the stack, deeper nesting spills to the heap.
+    class ContainerStack {
+    public:
+        static const int CAPACITY = 16;
+
+        ContainerStack() : shapes(fixed), size(0), capacity(CAPACITY) {}
+        ContainerStack(const ContainerStack &) = delete;
+        ContainerStack& operator=(const ContainerStack &) = delete;
+
+        void push(const Shape *shape)
+        {
+            if (size == capacity) {
+                std::vector<const Shape*> grown(shapes, shapes + size);
+                grown.resize(2 * capacity);
+                spilled.swap(grown);
+                shapes = spilled.data();
+                capacity *= 2;
+            }
+            shapes[size++] = shape;
+        }
+
+        bool remove(const Shape *shape)
+        {
+            for (int i = size - 1; i >= 0; i--) {
+                if (shapes[i] == shape) {
+                    std::copy(shapes + i + 1, shapes + size, shapes + i);
+                    size--;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Refractive index of the innermost shape, 1 outside of everything.
+        double refractiveIndex() const
+        {
+            return size == 0 ? 1.0 : shapes[size - 1]->getMaterial().refractiveIndex;
+        }
+
+    private:
+        const Shape *fixed[CAPACITY];
+        std::vector<const Shape*> spilled;
+        const Shape **shapes;
+        int size;
+        int capacity;
+    };
+}
+
+Intersection::Intersection(double value, const Shape* o) : t(value), object(o), primitive(-1), u(0), v(0)
+{
+}
+
+Intersection::Intersection(double value, const std::shared_ptr<const Shape>& o) : t(value), object(o.get()), primitive(-1), u(0), v(0)
+{
+}
+
+Intersection::Intersection(double value, const Shape* o, int primitive, double u, double v) : t(value), object(o), primitive(primitive), u(u), v(v)
 {
 }
 
@@ -11,11 +71,26 @@ double Intersection::getT() const
     return t;
 }
 
-const std::shared_ptr<const Shape>& Intersection::getObject() const
+const Shape* Intersection::getObject() const
 {
     return object;
 }
 
+int Intersection::getPrimitive() const
+{
+    return primitive;
+}
+
+double Intersection::getU() const
+{
+    return u;
+}
+
+double Intersection::getV() const
+{
+    return v;
+}
+
 bool Intersection::operator==(const Intersection &other) const
 {
     return object == other.object && t == other.t;
@@ -39,9 +114,10 @@ std::optional<Intersection> Intersection::hit(const std::vector<Intersection> &i
 
 Hit Intersection::prepareHit(const Ray & ray, const std::vector<Intersection>& intersections) const
 {
+    RenderStats::local().prepareHitCalls++;
     Tuple point = Ray::position(ray, t);
     Tuple eyev = -ray.direction;
-    Tuple normalv = object->normalAt(point);
+    Tuple normalv = object->normalAt(point, *this);
     Tuple reflectv = Tuple::reflect(ray.direction, normalv);
     bool inside;
 
@@ -54,45 +130,28 @@ Hit Intersection::prepareHit(const Ray & ray, const std::vector<Intersection>& i
         inside = false;
     }
 
-    double n1, n2;
-    n1 = n2 = 0;
-
-    std::vector<std::shared_ptr<const Shape>> containers;
-    for (const Intersection& i : intersections)
+    // Only refraction reads n1 and n2, so opaque hits don't need to know which shapes the ray is inside.
+    double n1 = 1.0, n2 = 1.0;
+    if (object->getMaterial().transparency > 0)
     {
-        if (t == i.getT())
+        ContainerStack containers;
+        for (const Intersection& i : intersections)
         {
-            if (containers.empty())
+            if (t == i.getT())
             {
-                n1 = 1.0;
+                n1 = containers.refractiveIndex();
             }
-            else
-            {
-                n1 = containers.back()->getMaterial().refractiveIndex;
-            }
-        }
-
-        std::vector<std::shared_ptr<const Shape>>::iterator index = std::find(containers.begin(), containers.end(), i.getObject());
-        if (index != containers.end())
-        {
-            containers.erase(index);
-        }
-        else
-        {
-            containers.push_back(i.getObject());
-        }
 
-        if (t == i.getT()) 
-        {
-            if (containers.empty())
+            if (!containers.remove(i.getObject()))
             {
-                n2 = 1.0;
+                containers.push(i.getObject());
             }
-            else
+
+            if (t == i.getT())
             {
-                n2 = containers.back()->getMaterial().refractiveIndex;
+                n2 = containers.refractiveIndex();
+                break;
             }
-            break;
         }
     }
 
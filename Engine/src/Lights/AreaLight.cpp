@@ -1,4 +1,5 @@
 #include <Lights/AreaLight.h>
+#include <Sampling.h>
 
 AreaLight::AreaLight(const Color & c, const Tuple & corner, const Tuple & fullUVec, int usteps, const Tuple & fullVVec, int vsteps, bool sampleJitter) :
     Light(c),
@@ -19,13 +20,51 @@ Tuple AreaLight::sample(int u, int v) const
     double vOffset = 0.5;
     
     if (jitter) {
-        uOffset = ((double)rand()) / RAND_MAX;
-        vOffset = ((double)rand()) / RAND_MAX;
+        Sampling::Pcg32 &generator = Sampling::Pcg32::threadLocal();
+        uOffset = generator.nextDouble();
+        vOffset = generator.nextDouble();
     }
 
     return lowerLeftCorner + uVec * (u + uOffset) + vVec * (v + vOffset);
 }
 
+Tuple AreaLight::samplePosition(int index, const Tuple & point) const
+{
+    if (!jitter) {
+        return sample(index / vSteps, index % vSteps);
+    }
+
+    Sampling::Pcg32 generator(Sampling::hash(point));
+    const double u = Sampling::scrambledSobol(0, index, generator.next());
+    const double v = Sampling::scrambledSobol(1, index, generator.next());
+
+    return lowerLeftCorner + uVec * (u * uSteps) + vVec * (v * vSteps);
+}
+
+int AreaLight::probeCount() const
+{
+    // A single probe would always agree with itself and turn every shadow hard. Odd lattices already pass through the
+    // center.
+    if (probeSteps < 2) {
+        return 0;
+    }
+    return probeSteps * probeSteps + (probeSteps % 2 == 0 ? 1 : 0);
+}
+
+Tuple AreaLight::probePosition(int index) const
+{
+    if (probeSteps % 2 == 0) {
+        if (index == 0) {
+            return center;
+        }
+        index--;
+    }
+
+    const int u = index / probeSteps;
+    const int v = index % probeSteps;
+    return lowerLeftCorner + uVec * (u * uSteps / double(probeSteps - 1)) + vVec * (v * vSteps / double(probeSteps - 1));
+}
+
 Color AreaLight::lighting(const Tuple & point, Color & color, double ambient, double diffuse, double specular, double shininess, double visibility, const Tuple & eyev, const Tuple & nv) const
 {
     Color ambientComponent = color * ambient;
@@ -33,22 +72,19 @@ Color AreaLight::lighting(const Tuple & point, Color & color, double ambient, do
     Color specularComponent = Color::Color(0, 0, 0);
 
     if (visibility > 0) {
-        for (int u = 0; u < uSteps; u++) {
-            for (int v = 0; v < vSteps; v++) {
-
-                Tuple lightPosition = sample(u, v);
-                Tuple lightv = Tuple::normalize(lightPosition - point);
-
-                double lightDotNormal = Tuple::dot(lightv, nv);
-                if (lightDotNormal >= 0.0) {
-                    diffuseComponent = diffuseComponent + (color * diffuse * lightDotNormal);
-
-                    Tuple reflectv = Tuple::reflect(-lightv, nv);
-                    double reflectDotEye = Tuple::dot(reflectv, eyev);
-                    if (reflectDotEye > 0) {
-                        double factor = pow(reflectDotEye, shininess);
-                        specularComponent = specularComponent + (intensity * specular * factor);
-                    }
+        for (int i = 0; i < samples; i++) {
+            Tuple lightPosition = samplePosition(i, point);
+            Tuple lightv = Tuple::normalize(lightPosition - point);
+
+            double lightDotNormal = Tuple::dot(lightv, nv);
+            if (lightDotNormal >= 0.0) {
+                diffuseComponent = diffuseComponent + (color * diffuse * lightDotNormal);
+
+                Tuple reflectv = Tuple::reflect(-lightv, nv);
+                double reflectDotEye = Tuple::dot(reflectv, eyev);
+                if (reflectDotEye > 0) {
+                    double factor = pow(reflectDotEye, shininess);
+                    specularComponent = specularComponent + (intensity * specular * factor);
                 }
             }
         }
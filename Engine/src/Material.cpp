@@ -1,4 +1,5 @@
 #include <Material.h>
+#include <RenderStats.h>
 
 Material::Material() : color(Color::Color(1.0, 1.0, 1.0)) , ambient(0.1), diffuse(0.9), specular(0.9), shininess(200), reflective(0), transparency(0), refractiveIndex(1)
 {
@@ -18,10 +19,32 @@ bool Material::operator==(const Material & other) const
         && shininess == other.shininess;
 }
 
-Color Material::lighting(const Matrix &objectInverseTransform, const Light &light, const Tuple & point, const Tuple & eyev, const Tuple & nv, double intensity) const
+Color Material::lighting(const Matrix4 &objectInverseTransform, const Light &light, const Tuple & point, const Tuple & eyev, const Tuple & nv, double intensity, double footprint, const std::optional<SurfaceUV> &surfaceUV) const
 {
-    Color materialColor = texture ? texture->atObject(objectInverseTransform, point) : color;
-    Color effectiveColor = materialColor * light.intensity;
+    StageTimer timer(&RenderStats::lightingSeconds);
+    Color effectiveColor = colorAt(objectInverseTransform, point, footprint, surfaceUV) * light.intensity;
 
     return light.lighting(point, effectiveColor, ambient, diffuse, specular, shininess, intensity, eyev, nv);
-}
\ No newline at end of file
+}
+
+Color Material::ambientLighting(const Matrix4 &objectInverseTransform, const Color &lightIntensity, const Tuple & point, double footprint, const std::optional<SurfaceUV> &surfaceUV) const
+{
+    StageTimer timer(&RenderStats::lightingSeconds);
+    return colorAt(objectInverseTransform, point, footprint, surfaceUV) * lightIntensity * ambient;
+}
+
+Color Material::directLighting(const Matrix4 &objectInverseTransform, const Light &light, const Tuple & point, const Tuple & eyev, const Tuple & nv, double intensity, double footprint, const std::optional<SurfaceUV> &surfaceUV) const
+{
+    StageTimer timer(&RenderStats::lightingSeconds);
+    Color effectiveColor = colorAt(objectInverseTransform, point, footprint, surfaceUV) * light.intensity;
+
+    return light.lighting(point, effectiveColor, 0.0, diffuse, specular, shininess, intensity, eyev, nv);
+}
+
+Color Material::colorAt(const Matrix4 &objectInverseTransform, const Tuple & point, double footprint, const std::optional<SurfaceUV> &surfaceUV) const
+{
+    if (!texture) {
+        return color;
+    }
+    return surfaceUV ? texture->atSurface(*surfaceUV, footprint) : texture->atObject(objectInverseTransform, point, footprint);
+}
@@ -0,0 +1,46 @@
+#include <Matrix4.h>
+#include <math.h>
+
+Matrix4 Matrix4::rotationX(double angle)
+{
+    Matrix4 result = identity();
+    result(1, 1) = cos(angle);
+    result(2, 2) = cos(angle);
+    result(1, 2) = -sin(angle);
+    result(2, 1) = sin(angle);
+    return result;
+}
+
+Matrix4 Matrix4::rotationY(double angle)
+{
+    Matrix4 result = identity();
+    result(0, 0) = cos(angle);
+    result(2, 2) = cos(angle);
+    result(2, 0) = -sin(angle);
+    result(0, 2) = sin(angle);
+    return result;
+}
+
+Matrix4 Matrix4::rotationZ(double angle)
+{
+    Matrix4 result = identity();
+    result(0, 0) = cos(angle);
+    result(1, 1) = cos(angle);
+    result(0, 1) = -sin(angle);
+    result(1, 0) = sin(angle);
+    return result;
+}
+
+Matrix4 Matrix4::viewTransform(const Tuple &from, const Tuple &to, const Tuple &up)
+{
+    Tuple forward = Tuple::normalize(to - from);
+    Tuple upn = Tuple::normalize(up);
+    Tuple left = Tuple::cross(forward, upn);
+    Tuple trueUp = Tuple::cross(left, forward);
+
+    Matrix4 orientation = Matrix4({ left[0], left[1], left[2], 0,
+                                    trueUp[0], trueUp[1], trueUp[2], 0,
+                                    -forward[0], -forward[1], -forward[2], 0,
+                                    0, 0, 0, 1 });
+    return orientation * Matrix4::translation(-from[0], -from[1], -from[2]);
+}
@@ -0,0 +1,123 @@
+#include <OBJParser.h>
+#include <fstream>
+#include <stdexcept>
+#include <cstdlib>
+
+static const char* skipSpaces(const char *c)
+{
+    while (*c == ' ' || *c == '\t' || *c == '\r') {
+        c++;
+    }
+    return c;
+}
+
+static double parseNumber(const char *&c)
+{
+    char *end;
+    double result = strtod(c, &end);
+    if (end == c) {
+        throw std::invalid_argument("expected a number in OBJ file");
+    }
+    c = end;
+    return result;
+}
+
+// OBJ indices start at 1, negative ones count back from the last element read so far.
+static int resolveIndex(long index, size_t count)
+{
+    long resolved = index > 0 ? index - 1 : static_cast<long>(count) + index;
+    if (index == 0 || resolved < 0 || resolved >= static_cast<long>(count)) {
+        throw std::invalid_argument("index out of range in OBJ file");
+    }
+    return static_cast<int>(resolved);
+}
+
+static long parseIndex(const char *&c)
+{
+    char *end;
+    long result = strtol(c, &end, 10);
+    if (end == c) {
+        throw std::invalid_argument("expected an index in OBJ file");
+    }
+    c = end;
+    return result;
+}
+
+MeshData OBJParser::parseOBJ(std::istream & input)
+{
+    MeshData result;
+    std::vector<int> facePositions, faceNormals, faceUVs;
+    std::string line;
+
+    while (std::getline(input, line)) {
+        const char *c = skipSpaces(line.c_str());
+
+        if (c[0] == 'v' && (c[1] == ' ' || c[1] == '\t')) {
+            c += 1;
+            for (int i = 0; i < 3; i++) {
+                result.positions.push_back(parseNumber(c));
+            }
+        }
+        else if (c[0] == 'v' && c[1] == 'n') {
+            c += 2;
+            for (int i = 0; i < 3; i++) {
+                result.normals.push_back(parseNumber(c));
+            }
+        }
+        else if (c[0] == 'v' && c[1] == 't') {
+            c += 2;
+            for (int i = 0; i < 2; i++) {
+                result.uvs.push_back(parseNumber(c));
+            }
+        }
+        else if (c[0] == 'f' && (c[1] == ' ' || c[1] == '\t')) {
+            c = skipSpaces(c + 1);
+            facePositions.clear();
+            faceNormals.clear();
+            faceUVs.clear();
+
+            // Corners come as v, v/vt, v//vn or v/vt/vn.
+            while (*c != '\0' && *c != '#') {
+                facePositions.push_back(resolveIndex(parseIndex(c), result.positions.size() / 3));
+                int uv = -1, normal = -1;
+                if (*c == '/') {
+                    c++;
+                    if (*c != '/') {
+                        uv = resolveIndex(parseIndex(c), result.uvs.size() / 2);
+                    }
+                    if (*c == '/') {
+                        c++;
+                        normal = resolveIndex(parseIndex(c), result.normals.size() / 3);
+                    }
+                }
+                faceUVs.push_back(uv);
+                faceNormals.push_back(normal);
+                c = skipSpaces(c);
+            }
+
+            if (facePositions.size() < 3) {
+                throw std::invalid_argument("face with less than three vertices in OBJ file");
+            }
+
+            for (size_t i = 1; i + 1 < facePositions.size(); i++) {
+                const size_t corners[3] = { 0, i, i + 1 };
+                for (size_t corner : corners) {
+                    result.positionIndices.push_back(facePositions[corner]);
+                    result.normalIndices.push_back(faceNormals[corner]);
+                    result.uvIndices.push_back(faceUVs[corner]);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+std::shared_ptr<TriangleMesh> OBJParser::meshFromFile(std::string inputPath)
+{
+    std::ifstream input(inputPath);
+    if (!input) {
+        throw std::invalid_argument("Could not open the OBJ file: " + inputPath);
+    }
+    return TriangleMesh::createTriangleMesh(parseOBJ(input));
+}
@@ -18,7 +18,7 @@ Tuple Ray::position(const Ray &r, double t)
     return r.origin + (r.direction * t);
 }
 
-Ray Ray::transform(const Ray & r, const Matrix & m)
+Ray Ray::transform(const Ray & r, const Matrix4 & m)
 {
     return Ray(m * r.origin, m * r.direction);
 }
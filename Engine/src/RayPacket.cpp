@@ -0,0 +1,70 @@
+#include <RayPacket.h>
+#include <limits>
+#include <stdexcept>
+
+RayPacket::RayPacket() : size(0)
+{
+}
+
+void RayPacket::add(const Ray & r)
+{
+    if (size >= MAX_SIZE) {
+        throw std::invalid_argument("ray packet is full");
+    }
+
+    originX[size] = r.origin[0];
+    originY[size] = r.origin[1];
+    originZ[size] = r.origin[2];
+    directionX[size] = r.direction[0];
+    directionY[size] = r.direction[1];
+    directionZ[size] = r.direction[2];
+    inverseX[size] = 1.0 / r.direction[0];
+    inverseY[size] = 1.0 / r.direction[1];
+    inverseZ[size] = 1.0 / r.direction[2];
+    size++;
+}
+
+Ray RayPacket::getRay(int lane) const
+{
+    return Ray(Tuple::point(originX[lane], originY[lane], originZ[lane]),
+               Tuple::vector(directionX[lane], directionY[lane], directionZ[lane]));
+}
+
+RayPacket RayPacket::transform(const RayPacket & p, const Matrix4 & m)
+{
+    // Same arithmetic as Ray::transform, lane by lane, so packet and single ray hits agree exactly.
+    RayPacket result;
+    result.size = p.size;
+    for (int i = 0; i < p.size; i++) {
+        const double ox = p.originX[i], oy = p.originY[i], oz = p.originZ[i];
+        const double dx = p.directionX[i], dy = p.directionY[i], dz = p.directionZ[i];
+        result.originX[i] = m(0, 0) * ox + m(0, 1) * oy + m(0, 2) * oz + m(0, 3);
+        result.originY[i] = m(1, 0) * ox + m(1, 1) * oy + m(1, 2) * oz + m(1, 3);
+        result.originZ[i] = m(2, 0) * ox + m(2, 1) * oy + m(2, 2) * oz + m(2, 3);
+        result.directionX[i] = m(0, 0) * dx + m(0, 1) * dy + m(0, 2) * dz;
+        result.directionY[i] = m(1, 0) * dx + m(1, 1) * dy + m(1, 2) * dz;
+        result.directionZ[i] = m(2, 0) * dx + m(2, 1) * dy + m(2, 2) * dz;
+    }
+    for (int i = 0; i < p.size; i++) {
+        result.inverseX[i] = 1.0 / result.directionX[i];
+        result.inverseY[i] = 1.0 / result.directionY[i];
+        result.inverseZ[i] = 1.0 / result.directionZ[i];
+    }
+    return result;
+}
+
+PacketHits::PacketHits()
+{
+    for (int i = 0; i < RayPacket::MAX_SIZE; i++) {
+        t[i] = std::numeric_limits<double>::infinity();
+        object[i] = nullptr;
+        primitive[i] = -1;
+        u[i] = 0;
+        v[i] = 0;
+    }
+}
+
+Intersection PacketHits::getIntersection(int lane) const
+{
+    return Intersection(t[lane], object[lane], primitive[lane], u[lane], v[lane]);
+}
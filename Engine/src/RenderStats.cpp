@@ -0,0 +1,130 @@
+#include <RenderStats.h>
+#include <json.hpp>
+#include <atomic>
+#include <mutex>
+
+static std::mutex totalsMutex;
+static RenderStats totals;
+static std::atomic<bool> timingEnabled(false);
+
+RenderStatsDetail::ThreadStats::~ThreadStats()
+{
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    totals.merge(stats);
+}
+
+void RenderStats::merge(const RenderStats & other)
+{
+    primaryRays += other.primaryRays;
+    shadowRays += other.shadowRays;
+    reflectionRays += other.reflectionRays;
+    refractionRays += other.refractionRays;
+    terminatedRays += other.terminatedRays;
+    extraSamples += other.extraSamples;
+    refinedPixels += other.refinedPixels;
+    sphereTests += other.sphereTests;
+    planeTests += other.planeTests;
+    cubeTests += other.cubeTests;
+    meshTests += other.meshTests;
+    triangleTests += other.triangleTests;
+    instanceTests += other.instanceTests;
+    bvhNodeVisits += other.bvhNodeVisits;
+    prepareHitCalls += other.prepareHitCalls;
+    shadeHitSeconds += other.shadeHitSeconds;
+    lightingSeconds += other.lightingSeconds;
+    textureSeconds += other.textureSeconds;
+    imageIOSeconds += other.imageIOSeconds;
+}
+
+void RenderStats::print(std::ostream & out) const
+{
+    out << "Rays: " << primaryRays << " primary, " << shadowRays << " shadow, "
+        << reflectionRays << " reflection, " << refractionRays << " refraction\n";
+    if (terminatedRays > 0) {
+        out << "Russian roulette: " << terminatedRays << " secondary rays terminated\n";
+    }
+    if (extraSamples > 0) {
+        out << "Anti-aliasing: " << extraSamples << " extra samples on " << refinedPixels << " pixels\n";
+    }
+    out << "Intersection tests: " << sphereTests << " sphere, " << planeTests << " plane, " << cubeTests << " cube, "
+        << meshTests << " mesh (" << triangleTests << " triangles), " << instanceTests << " instance\n";
+    out << "BVH node visits: " << bvhNodeVisits << "\n";
+    out << "prepareHit calls: " << prepareHitCalls << "\n";
+    if (timingEnabled) {
+        out << "Time (summed over threads): shadeHit " << shadeHitSeconds << "s, lighting " << lightingSeconds
+            << "s, texture lookups " << textureSeconds << "s, image I/O " << imageIOSeconds << "s\n";
+    }
+}
+
+std::string RenderStats::toJSON() const
+{
+    nlohmann::json json;
+    json["rays"] = {
+        { "primary", primaryRays },
+        { "shadow", shadowRays },
+        { "reflection", reflectionRays },
+        { "refraction", refractionRays },
+        { "terminated", terminatedRays }
+    };
+    json["antialiasing"] = {
+        { "extraSamples", extraSamples },
+        { "refinedPixels", refinedPixels }
+    };
+    json["intersectionTests"] = {
+        { "sphere", sphereTests },
+        { "plane", planeTests },
+        { "cube", cubeTests },
+        { "mesh", meshTests },
+        { "triangle", triangleTests },
+        { "instance", instanceTests }
+    };
+    json["bvhNodeVisits"] = bvhNodeVisits;
+    json["prepareHitCalls"] = prepareHitCalls;
+    json["seconds"] = {
+        { "shadeHit", shadeHitSeconds },
+        { "lighting", lightingSeconds },
+        { "texture", textureSeconds },
+        { "imageIO", imageIOSeconds }
+    };
+    return json.dump(2);
+}
+
+RenderStats RenderStats::collect()
+{
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    RenderStats result = totals;
+    result.merge(local());
+    return result;
+}
+
+void RenderStats::reset()
+{
+    std::lock_guard<std::mutex> lock(totalsMutex);
+    totals = RenderStats();
+    local() = RenderStats();
+}
+
+void RenderStats::setTimingEnabled(bool enabled)
+{
+    timingEnabled = enabled;
+}
+
+bool RenderStats::isTimingEnabled()
+{
+    return timingEnabled;
+}
+
+StageTimer::StageTimer(double RenderStats::*stage, bool active) : stage(stage), active(active && timingEnabled)
+{
+    if (this->active) {
+        start = std::chrono::steady_clock::now();
+    }
+}
+
+StageTimer::~StageTimer()
+{
+    if (active) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        RenderStats::local().*stage += elapsed.count();
+    }
+}
@@ -0,0 +1,114 @@
+#include <Sampling.h>
+#include <atomic>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+
+static const double TO_UNIT = 1.0 / 4294967296.0;
+
+Sampling::Pcg32::Pcg32(uint64_t seed, uint64_t stream) : state(0), increment((stream << 1) | 1)
+{
+    next();
+    state += seed;
+    next();
+}
+
+uint32_t Sampling::Pcg32::next()
+{
+    const uint64_t old = state;
+    state = old * 6364136223846793005ull + increment;
+    const uint32_t xorShifted = static_cast<uint32_t>(((old >> 18) ^ old) >> 27);
+    const uint32_t rotation = static_cast<uint32_t>(old >> 59);
+    return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+}
+
+double Sampling::Pcg32::nextDouble()
+{
+    return next() * TO_UNIT;
+}
+
+Sampling::Pcg32& Sampling::Pcg32::threadLocal()
+{
+    static std::atomic<uint64_t> nextStream(0);
+    static thread_local Pcg32 generator(std::random_device{}(), nextStream++);
+    return generator;
+}
+
+double Sampling::radicalInverse(int base, uint32_t index)
+{
+    double result = 0.0;
+    double fraction = 1.0 / base;
+    while (index > 0) {
+        result += (index % base) * fraction;
+        index /= base;
+        fraction /= base;
+    }
+    return result;
+}
+
+static uint32_t reverseBits(uint32_t x)
+{
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ffu) << 8) | ((x & 0xff00ff00u) >> 8);
+    x = ((x & 0x0f0f0f0fu) << 4) | ((x & 0xf0f0f0f0u) >> 4);
+    x = ((x & 0x33333333u) << 2) | ((x & 0xccccccccu) >> 2);
+    return ((x & 0x55555555u) << 1) | ((x & 0xaaaaaaaau) >> 1);
+}
+
+// Bits of a Sobol point, the most significant one is the first binary digit after the radix point.
+static uint32_t sobolBits(int dimension, uint32_t index)
+{
+    if (dimension < 0 || dimension > 1) {
+        throw std::invalid_argument("only the first two Sobol dimensions are available");
+    }
+    if (dimension == 0) {
+        return reverseBits(index);
+    }
+
+    // Each set bit of the index XORs in one column of the generator matrix.
+    uint32_t result = 0;
+    for (uint32_t column = 1u << 31; index != 0; index >>= 1, column ^= column >> 1) {
+        if (index & 1) {
+            result ^= column;
+        }
+    }
+    return result;
+}
+
+double Sampling::sobol(int dimension, uint32_t index)
+{
+    return sobolBits(dimension, index) * TO_UNIT;
+}
+
+double Sampling::scrambledSobol(int dimension, uint32_t index, uint32_t seed)
+{
+    // Hash based Owen scrambling (Burley 2020). With the bits reversed, a multiply only carries from lower to higher
+    // bits, so every digit gets flipped depending on the seed and the digits before it, never the ones after.
+    uint32_t x = reverseBits(sobolBits(dimension, index));
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return reverseBits(x) * TO_UNIT;
+}
+
+// Finalizer of SplitMix64, every input bit affects every output bit.
+static uint64_t mix(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+uint64_t Sampling::hash(const Tuple &point)
+{
+    uint64_t result = 0x9e3779b97f4a7c15ull;
+    for (int i = 0; i < 3; i++) {
+        const double coordinate = point[i];
+        uint64_t bits;
+        std::memcpy(&bits, &coordinate, sizeof(bits));
+        result = mix(result ^ bits);
+    }
+    return result;
+}
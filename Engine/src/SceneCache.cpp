@@ -0,0 +1,312 @@
+#include <SceneCache.h>
+#include <ImageIOInterface.h>
+#include <OBJParser.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Bumped whenever the layout of an entry changes, so entries of older builds are rebuilt instead of misread.
+static const uint32_t CACHE_VERSION = 3;
+static const char CACHE_MAGIC[8] = { 'R', 'A', 'Y', 'C', 'A', 'C', 'H', 'E' };
+
+enum class EntryKind : uint32_t { Mesh = 1, Texture = 3 };
+
+// Every entry starts with this. The BVH node size tells builds with and without RAYMOND_SINGLE_PRECISION apart.
+struct EntryHeader {
+    char magic[8];
+    uint32_t version;
+    EntryKind kind;
+    uint64_t sourceHash;
+    uint32_t nodeSize;
+    uint32_t reserved;
+};
+
+// Read-only view of a whole file, empty when it can't be opened.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize)) {
+            if (fileSize.QuadPart > 0) {
+                HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (mapping != NULL) {
+                    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+                    CloseHandle(mapping);
+                }
+                size = view != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+            }
+            opened = view != nullptr || fileSize.QuadPart == 0;
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            return;
+        }
+        struct stat status;
+        if (fstat(file, &status) == 0) {
+            if (status.st_size > 0) {
+                void *mapped = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+                if (mapped != MAP_FAILED) {
+                    view = mapped;
+                    size = static_cast<size_t>(status.st_size);
+                }
+            }
+            opened = view != nullptr || status.st_size == 0;
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile()
+    {
+        if (view == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+#else
+        munmap(view, size);
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile& operator=(const MappedFile &) = delete;
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return static_cast<const char*>(view); }
+    size_t getSize() const { return size; }
+
+private:
+    void *view = nullptr;
+    size_t size = 0;
+    bool opened = false;
+};
+
+// Walks an entry front to back. Every read checks the remaining size, so a truncated entry is rejected instead of read
+// past its end.
+class EntryReader {
+public:
+    EntryReader(const char *data, size_t size) : current(data), end(data + size) {}
+
+    bool read(void *out, size_t bytes)
+    {
+        if (static_cast<size_t>(end - current) < bytes) {
+            return false;
+        }
+        std::memcpy(out, current, bytes);
+        current += bytes;
+        return true;
+    }
+
+    template <typename T>
+    bool readArray(std::vector<T> &out)
+    {
+        uint64_t count;
+        if (!read(&count, sizeof(count)) || count > static_cast<uint64_t>(end - current) / sizeof(T)) {
+            return false;
+        }
+        out.resize(static_cast<size_t>(count));
+        return read(out.data(), out.size() * sizeof(T));
+    }
+
+    bool atEnd() const { return current == end; }
+
+private:
+    const char *current;
+    const char *end;
+};
+
+template <typename T>
+static void writeArray(std::ofstream &file, const std::vector<T> &values)
+{
+    const uint64_t count = values.size();
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+static EntryHeader makeHeader(EntryKind kind, uint64_t sourceHash)
+{
+    EntryHeader header;
+    std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.kind = kind;
+    header.sourceHash = sourceHash;
+    header.nodeSize = sizeof(BVHNode);
+    header.reserved = 0;
+    return header;
+}
+
+static bool readHeader(EntryReader &reader, EntryKind kind, uint64_t sourceHash)
+{
+    EntryHeader header;
+    if (!reader.read(&header, sizeof(header))) {
+        return false;
+    }
+    const EntryHeader expected = makeHeader(kind, sourceHash);
+    return std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version
+        && header.kind == expected.kind && header.sourceHash == expected.sourceHash && header.nodeSize == expected.nodeSize;
+}
+
+static std::string entryPath(const std::string &cacheDirectory, uint64_t sourceHash, const char *extension)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(sourceHash), extension);
+    return (std::filesystem::path(cacheDirectory) / name).string();
+}
+
+// Process id and a counter, so writers that miss the cache at the same time never share a temporary file.
+static std::string temporarySuffix()
+{
+    static std::atomic<unsigned> counter(0);
+#ifdef _WIN32
+    const unsigned long process = GetCurrentProcessId();
+#else
+    const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+    return ".tmp" + std::to_string(process) + "-" + std::to_string(counter++);
+}
+
+// Writes to a temporary file of its own first and renames it into place, so a render running at the same time never
+// maps a half written entry. When two writers race, the last rename wins, both wrote the same contents.
+// The cache only saves time: an entry that can't be written is reported and skipped, the load goes on without it.
+template <typename WriteBody>
+static void writeEntry(const std::string &path, EntryKind kind, uint64_t sourceHash, WriteBody writeBody)
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+    const std::string temporaryPath = path + temporarySuffix();
+    if (!error) {
+        std::ofstream file(temporaryPath, std::ios::binary);
+        const EntryHeader header = makeHeader(kind, sourceHash);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeBody(file);
+        file.close();
+        if (!file) {
+            error = std::make_error_code(std::errc::io_error);
+        }
+    }
+    if (!error) {
+        std::filesystem::rename(temporaryPath, path, error);
+    }
+    if (error) {
+        std::error_code ignored;
+        std::filesystem::remove(temporaryPath, ignored);
+        std::cout << "Could not write the scene cache entry " << path << ": " << error.message() << "\n";
+    }
+}
+
+uint64_t SceneCache::hashFile(const std::string & path)
+{
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        throw std::invalid_argument("Could not read: " + path);
+    }
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < file.getSize(); i++) {
+        hash = (hash ^ static_cast<uint8_t>(file.data()[i])) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::shared_ptr<TriangleMesh> SceneCache::loadMesh(const std::string & objPath, const std::string & cacheDirectory)
+{
+    if (cacheDirectory.empty()) {
+        return OBJParser::meshFromFile(objPath);
+    }
+
+    const uint64_t sourceHash = hashFile(objPath);
+    const std::string path = entryPath(cacheDirectory, sourceHash, ".mesh");
+    {
+        MappedFile entry(path);
+        EntryReader reader(entry.data(), entry.getSize());
+        MeshData data;
+        std::vector<BVHNode> nodes;
+        std::vector<int> primitiveIndices;
+        if (entry.isOpen() && readHeader(reader, EntryKind::Mesh, sourceHash)
+            && reader.readArray(data.positions) && reader.readArray(data.normals) && reader.readArray(data.uvs)
+            && reader.readArray(data.positionIndices) && reader.readArray(data.normalIndices) && reader.readArray(data.uvIndices)
+            && reader.readArray(nodes) && reader.readArray(primitiveIndices) && reader.atEnd()) {
+            // An entry that doesn't hold together is rebuilt like a missing one.
+            try {
+                return TriangleMesh::createTriangleMesh(std::move(data), BVH(std::move(nodes), std::move(primitiveIndices)));
+            }
+            catch (const std::invalid_argument &) {
+            }
+        }
+    }
+
+    std::shared_ptr<TriangleMesh> mesh = OBJParser::meshFromFile(objPath);
+    writeEntry(path, EntryKind::Mesh, sourceHash, [&](std::ofstream &file) {
+        const MeshData &data = mesh->getData();
+        writeArray(file, data.positions);
+        writeArray(file, data.normals);
+        writeArray(file, data.uvs);
+        writeArray(file, data.positionIndices);
+        writeArray(file, data.normalIndices);
+        writeArray(file, data.uvIndices);
+        writeArray(file, mesh->getBVH().getNodes());
+        writeArray(file, mesh->getBVH().getPrimitiveIndices());
+    });
+    return mesh;
+}
+
+std::shared_ptr<UVImage> SceneCache::loadTexture(const std::string & imagePath, const std::string & cacheDirectory)
+{
+    if (cacheDirectory.empty()) {
+        return ImageIOInterface::textureFromImage(imagePath);
+    }
+
+    const uint64_t sourceHash = hashFile(imagePath);
+    const std::string path = entryPath(cacheDirectory, sourceHash, ".texture");
+    {
+        MappedFile entry(path);
+        EntryReader reader(entry.data(), entry.getSize());
+        int32_t size[2];
+        UVImage::Format format;
+        std::vector<uint8_t> texels;
+        if (entry.isOpen() && readHeader(reader, EntryKind::Texture, sourceHash) && reader.read(size, sizeof(size))
+            && reader.read(&format, sizeof(format)) && reader.readArray(texels) && reader.atEnd()) {
+            try {
+                return UVImage::createUVImage(size[0], size[1], format, std::move(texels));
+            }
+            catch (const std::invalid_argument &) {
+            }
+        }
+    }
+
+    std::shared_ptr<UVImage> image = ImageIOInterface::textureFromImage(imagePath);
+    writeEntry(path, EntryKind::Texture, sourceHash, [&](std::ofstream &file) {
+        const int32_t size[2] = { image->getWidth(), image->getHeight() };
+        const UVImage::Format format = image->getFormat();
+        file.write(reinterpret_cast<const char*>(size), sizeof(size));
+        file.write(reinterpret_cast<const char*>(&format), sizeof(format));
+        writeArray(file, image->getTexels());
+    });
+    return image;
+}
@@ -1,44 +1,47 @@
 #include <SceneParser.h>
-#include <ImageIOInterface.h>
 #include <Shapes/Sphere.h>
 #include <Shapes/Plane.h>
 #include <Shapes/Cube.h>
+#include <Shapes/TriangleMesh.h>
+#include <Shapes/Instance.h>
+#include <SceneCache.h>
 #include <Texture/UVImage.h>
 #include <Texture/Patterns/Checkers.h>
 #include <Texture/Patterns/Ring.h>
 #include <Texture/Patterns/Stripe.h>
 #include <Texture/Patterns/Gradient.h>
+#include <cmath>
 #include <map>
 #include <iostream>
 #include <stdexcept>
 
-Matrix getTransformMatrix(nlohmann::json json) {
-	Matrix result = Matrix::getIdentity4x4();
+Matrix4 getTransformMatrix(nlohmann::json json) {
+	Matrix4 result = Matrix4::identity();
 
 	if (json.find("scaling") != json.end())
 	{
-		Matrix scaling = Matrix::scaling(json["scaling"][0], json["scaling"][1], json["scaling"][2]);
+		Matrix4 scaling = Matrix4::scaling(json["scaling"][0], json["scaling"][1], json["scaling"][2]);
 		result = scaling * result;
 	}
 
 	if (json.find("rotation") != json.end())
 	{
-		Matrix rotationX = Matrix::rotationX(json["rotation"][0]);
-		Matrix rotationY = Matrix::rotationY(json["rotation"][1]);
-		Matrix rotationZ = Matrix::rotationZ(json["rotation"][2]);
+		Matrix4 rotationX = Matrix4::rotationX(json["rotation"][0]);
+		Matrix4 rotationY = Matrix4::rotationY(json["rotation"][1]);
+		Matrix4 rotationZ = Matrix4::rotationZ(json["rotation"][2]);
 		result = rotationZ * rotationY * rotationX * result;
 	}
 
 	if (json.find("translation") != json.end())
 	{
-		Matrix translation = Matrix::translation(json["translation"][0], json["translation"][1], json["translation"][2]);
+		Matrix4 translation = Matrix4::translation(json["translation"][0], json["translation"][1], json["translation"][2]);
 		result = translation * result;
 	}
 
 	return result;
 }
 
-std::shared_ptr<Texture> getTexture(nlohmann::json json) {
+std::shared_ptr<Texture> getTexture(nlohmann::json json, const std::string &cacheDirectory) {
 	std::shared_ptr<UVMapping> mapping;
 	if (json["mapping"].get<std::string>().compare("sphere") == 0) 
 	{
@@ -60,8 +63,7 @@ std::shared_ptr<Texture> getTexture(nlohmann::json json) {
 	std::shared_ptr<Texture> result;
 	if (json["pattern"].get<std::string>().compare("image") == 0) 
 	{
-		std::shared_ptr<Canvas> canvas = std::make_shared<Canvas>(ImageIOInterface::canvasFromImage(json["imagePath"]));
-		std::shared_ptr<UVImage> image = UVImage::createUVImage(canvas);
+		std::shared_ptr<UVImage> image = SceneCache::loadTexture(json["imagePath"], cacheDirectory);
 		result = Texture::createTexture(image, mapping);
 	}
 	else if (json["pattern"].get<std::string>().compare("stripe") == 0)
@@ -116,6 +118,43 @@ Material getMaterial(nlohmann::json json, std::map<std::string, std::shared_ptr<
 	return result;
 }
 
+std::shared_ptr<TriangleMesh> getMesh(std::string path, std::map<std::string, std::shared_ptr<TriangleMesh>> &meshMap, const std::string &cacheDirectory) {
+	if (meshMap.find(path) == meshMap.end())
+	{
+		meshMap.insert(std::make_pair(path, SceneCache::loadMesh(path, cacheDirectory)));
+	}
+	return std::make_shared<TriangleMesh>(*meshMap[path]);
+}
+
+std::shared_ptr<Shape> getPrototype(nlohmann::json json, std::map<std::string, Material> &materialMap, std::map<std::string, std::shared_ptr<TriangleMesh>> &meshMap,
+	const std::string &cacheDirectory) {
+	std::shared_ptr<Shape> result;
+	if (json["type"].get<std::string>().compare("sphere") == 0)
+	{
+		result = Sphere::createSphere();
+	}
+	else if (json["type"].get<std::string>().compare("plane") == 0)
+	{
+		result = Plane::createPlane();
+	}
+	else if (json["type"].get<std::string>().compare("cube") == 0)
+	{
+		result = Cube::createCube();
+	}
+	else if (json["type"].get<std::string>().compare("mesh") == 0)
+	{
+		result = getMesh(json["path"], meshMap, cacheDirectory);
+	}
+	else
+	{
+		throw std::invalid_argument("Unknown prototype type");
+	}
+
+	result->setTransform(getTransformMatrix(json));
+	result->setMaterial(materialMap[json["material"]]);
+	return result;
+}
+
 Camera SceneParser::getCameraFromSceneJSON(nlohmann::json sceneJson)
 {
 	nlohmann::json cameraJson = sceneJson["camera"];
@@ -127,17 +166,44 @@ Camera SceneParser::getCameraFromSceneJSON(nlohmann::json sceneJson)
 	const Tuple from = Tuple::point(cameraJson["from"][0], cameraJson["from"][1], cameraJson["from"][2]);
 	const Tuple to = Tuple::point(cameraJson["to"][0], cameraJson["to"][1], cameraJson["to"][2]);
 	const Tuple up = Tuple::point(cameraJson["up"][0], cameraJson["up"][1], cameraJson["up"][2]);
-	camera.setTransform(Matrix::viewTransform(from, to, up));
+	camera.setTransform(Matrix4::viewTransform(from, to, up));
 
 	return camera;
 }
 
 
-World SceneParser::getWorldFromSceneJSON(nlohmann::json sceneJson)
+World SceneParser::getWorldFromSceneJSON(nlohmann::json sceneJson, const std::string &cacheDirectory)
 {
 	World world = World();
+	if (sceneJson.find("maxBounces") != sceneJson.end())
+	{
+		int maxBounces = sceneJson["maxBounces"];
+		if (maxBounces < 0)
+		{
+			throw std::invalid_argument("Negative maxBounces");
+		}
+		world.setMaxBounces(maxBounces);
+	}
+	if (sceneJson.find("rouletteThreshold") != sceneJson.end())
+	{
+		double rouletteThreshold = sceneJson["rouletteThreshold"];
+		if (!std::isfinite(rouletteThreshold) || rouletteThreshold < 0)
+		{
+			throw std::invalid_argument("rouletteThreshold must be a finite number of at least 0");
+		}
+		world.setRouletteThreshold(rouletteThreshold);
+	}
 
 	nlohmann::json lights = sceneJson["lights"];
+	if (lights.find("samples") != lights.end())
+	{
+		int samples = lights["samples"];
+		if (samples < 0)
+		{
+			throw std::invalid_argument("Negative light samples");
+		}
+		world.setLightSamples(samples);
+	}
 
 	for (nlohmann::json light : lights["pointLights"]) 
 	{
@@ -158,6 +224,11 @@ World SceneParser::getWorldFromSceneJSON(nlohmann::json sceneJson)
 		bool jitter = light["jitter"];
 
 		AreaLight areaLight = AreaLight(intensity, corner, uvec, usteps, vvec, vsteps, jitter);
+		areaLight.probeSteps = light.value("probeSteps", 0);
+		if (areaLight.probeSteps < 0 || areaLight.probeSteps == 1)
+		{
+			throw std::invalid_argument("probeSteps must be 0 or at least 2");
+		}
 
 		world.addLight(areaLight);
 	}
@@ -166,7 +237,7 @@ World SceneParser::getWorldFromSceneJSON(nlohmann::json sceneJson)
 	nlohmann::json textures = sceneJson["textures"];
 	for (nlohmann::json texture : textures) 
 	{
-		textureMap.insert(std::make_pair(texture["name"], getTexture(texture)));
+		textureMap.insert(std::make_pair(texture["name"], getTexture(texture, cacheDirectory)));
 	}
 
 	std::map<std::string, Material> materialMap;
@@ -204,5 +275,37 @@ World SceneParser::getWorldFromSceneJSON(nlohmann::json sceneJson)
 		world.addObject(cube);
 	}
 
+	// Meshes loaded from the same file share their geometry and BVH.
+	std::map<std::string, std::shared_ptr<TriangleMesh>> meshMap;
+	for (nlohmann::json meshJson : shapes["meshes"])
+	{
+		std::shared_ptr<TriangleMesh> mesh = getMesh(meshJson["path"], meshMap, cacheDirectory);
+
+		mesh->setTransform(getTransformMatrix(meshJson));
+		mesh->setMaterial(materialMap[meshJson["material"]]);
+		world.addObject(mesh);
+	}
+
+	// Prototypes are not part of the world on their own, every instance only adds a transform on top of one.
+	std::map<std::string, std::shared_ptr<Shape>> prototypeMap;
+	nlohmann::json prototypes = sceneJson["prototypes"];
+	for (nlohmann::json prototype : prototypes)
+	{
+		prototypeMap.insert(std::make_pair(prototype["name"], getPrototype(prototype, materialMap, meshMap, cacheDirectory)));
+	}
+
+	for (nlohmann::json instanceJson : shapes["instances"])
+	{
+		std::map<std::string, std::shared_ptr<Shape>>::iterator prototype = prototypeMap.find(instanceJson["prototype"]);
+		if (prototype == prototypeMap.end())
+		{
+			throw std::invalid_argument("Missing prototype");
+		}
+		std::shared_ptr<Instance> instance = Instance::createInstance(prototype->second);
+
+		instance->setTransform(getTransformMatrix(instanceJson));
+		world.addObject(instance);
+	}
+
 	return world;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include <Shapes/Cube.h>
+#include <RenderStats.h>
 #include <algorithm>
+#include <cmath>
 
 static const double EPSILON = 0.000001;
 
@@ -13,18 +15,19 @@ bool Cube::operator==(const Shape & other) const
     return true;
 }
 
-void Cube::setTransform(const Matrix & m)
+void Cube::setTransform(const Matrix4 & m)
 {
     transform = m;
-    inverseTransform = Matrix::inverse(transform);
+    inverseTransform = Matrix4::inverse(transform);
+    normalTransform = Matrix4::normalMatrix(inverseTransform);
 }
 
-Matrix Cube::getTransform() const
+const Matrix4& Cube::getTransform() const
 {
     return transform;
 }
 
-Matrix Cube::getInverseTransform() const
+const Matrix4& Cube::getInverseTransform() const
 {
     return inverseTransform;
 }
@@ -39,7 +42,7 @@ Material & Cube::getMaterial()
     return material;
 }
 
-Material Cube::getMaterial() const
+const Material& Cube::getMaterial() const
 {
     return material;
 }
@@ -48,18 +51,23 @@ Tuple Cube::normalAt(const Tuple & point) const
 {
     Tuple objectPoint = inverseTransform * point;
 
-    std::vector<double> components = { abs(objectPoint[0]), abs(objectPoint[1]), abs(objectPoint[2]) };
-    int maxComponent = static_cast<int>(std::max_element(components.begin(), components.end()) - components.begin());
+    double components[3] = { abs(objectPoint[0]), abs(objectPoint[1]), abs(objectPoint[2]) };
+    int maxComponent = static_cast<int>(std::max_element(components, components + 3) - components);
 
-    Tuple result = Tuple::vector(0, 0, 0);
-    result[maxComponent] = objectPoint[maxComponent];
-    return result;
+    Tuple objectNormal = Tuple::vector(0, 0, 0);
+    objectNormal[maxComponent] = objectPoint[maxComponent];
+    return Tuple::normalize(normalTransform * objectNormal);
 }
 
-std::vector<Intersection> Cube::intersects(const Ray & r) const
+Bounds Cube::getBounds() const
 {
+    return Bounds(Tuple::point(-1, -1, -1), Tuple::point(1, 1, 1));
+}
+
+void Cube::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    RenderStats::local().cubeTests++;
      Ray ray = Ray::transform(r, inverseTransform);
-     std::vector<Intersection> result;
      
      std::pair<double, double> x = checkAxis(ray.origin[0], ray.direction[0]);
      std::pair<double, double> y = checkAxis(ray.origin[1], ray.direction[1]);
@@ -68,20 +76,55 @@ std::vector<Intersection> Cube::intersects(const Ray & r) const
      double tMin = std::max({x.first, y.first, z.first});
      double tMax = std::min({x.second, y.second, z.second});
 
-     if (tMin > tMax) {
-         return {};
+     if (tMin <= tMax) {
+         result.push_back(Intersection(tMin, this));
+         result.push_back(Intersection(tMax, this));
      }
+}
+
+void Cube::intersects(const RayPacket & packet, PacketHits & hits) const
+{
+    RenderStats::local().cubeTests += packet.size;
+    RayPacket local = RayPacket::transform(packet, inverseTransform);
+    const Real *origins[3] = { local.originX, local.originY, local.originZ };
+    const Real *directions[3] = { local.directionX, local.directionY, local.directionZ };
+
+    double tMin[RayPacket::MAX_SIZE], tMax[RayPacket::MAX_SIZE];
+    for (int i = 0; i < local.size; i++) {
+        tMin[i] = -INFINITY;
+        tMax[i] = INFINITY;
+    }
 
-     Intersection i1 = Intersection::Intersection(tMin, shared_from_this());
-     Intersection i2 = Intersection::Intersection(tMax, shared_from_this());
-     return { i1, i2 };
+    // checkAxis() for one axis across all lanes at a time.
+    for (int axis = 0; axis < 3; axis++) {
+        const Real *origin = origins[axis];
+        const Real *direction = directions[axis];
+        for (int i = 0; i < local.size; i++) {
+            const double tMinNumerator = (-1 - origin[i]);
+            const double tMaxNumerator = (1 - origin[i]);
+            const bool parallel = std::abs(direction[i]) < EPSILON;
+            double t0 = parallel ? tMinNumerator * INFINITY : tMinNumerator / direction[i];
+            double t1 = parallel ? tMaxNumerator * INFINITY : tMaxNumerator / direction[i];
+            if (t0 > t1) {
+                std::swap(t0, t1);
+            }
+            tMin[i] = t0 > tMin[i] ? t0 : tMin[i];
+            tMax[i] = t1 < tMax[i] ? t1 : tMax[i];
+        }
+    }
+
+    for (int i = 0; i < local.size; i++) {
+        if (tMin[i] <= tMax[i]) {
+            hits.record(i, tMin[i] > 0 ? tMin[i] : tMax[i], this);
+        }
+    }
 }
 
-Cube::Cube() : transform(Matrix::getIdentity4x4()), inverseTransform(Matrix::getIdentity4x4()), material(Material::Material()) {
+Cube::Cube() : transform(Matrix4::identity()), inverseTransform(Matrix4::identity()), normalTransform(Matrix4::normalMatrix(Matrix4::identity())), material(Material::Material()) {
 
 }
 
-std::pair<double, double> Cube::checkAxis(double origin, double direction) const
+std::pair<double, double> Cube::checkAxis(Real origin, Real direction) const
 {
     double tMinNumerator = (-1 - origin);
     double tMaxNumerator = (1 - origin);
@@ -0,0 +1,132 @@
+#include <Shapes/Instance.h>
+#include <RenderStats.h>
+#include <cmath>
+#include <stdexcept>
+
+std::shared_ptr<Instance> Instance::createInstance(const std::shared_ptr<Shape> &prototype)
+{
+    if (!prototype) {
+        throw std::invalid_argument("instance needs a prototype");
+    }
+    return std::make_shared<Instance>(Instance(prototype));
+}
+
+bool Instance::operator==(const Shape & /*other*/) const
+{
+    return true;
+}
+
+void Instance::setTransform(const Matrix4 & m)
+{
+    placement = m;
+    inversePlacement = Matrix4::inverse(placement);
+    placementNormalTransform = Matrix4::normalMatrix(inversePlacement);
+    transform = placement * prototype->getTransform();
+    inverseTransform = prototype->getInverseTransform() * inversePlacement;
+}
+
+const Matrix4& Instance::getTransform() const
+{
+    return transform;
+}
+
+const Matrix4& Instance::getInverseTransform() const
+{
+    return inverseTransform;
+}
+
+const Matrix4& Instance::getPlacement() const
+{
+    return placement;
+}
+
+void Instance::setMaterial(const Material & m)
+{
+    prototype->setMaterial(m);
+}
+
+Material & Instance::getMaterial()
+{
+    return prototype->getMaterial();
+}
+
+const Material& Instance::getMaterial() const
+{
+    return static_cast<const Shape&>(*prototype).getMaterial();
+}
+
+Tuple Instance::normalAt(const Tuple & point) const
+{
+    return toWorldNormal(prototype->normalAt(inversePlacement * point));
+}
+
+Tuple Instance::normalAt(const Tuple & point, const Intersection & hit) const
+{
+    return toWorldNormal(prototype->normalAt(inversePlacement * point, hit));
+}
+
+std::optional<SurfaceUV> Instance::surfaceUVAt(const Intersection & hit) const
+{
+    std::optional<SurfaceUV> surface = prototype->surfaceUVAt(hit);
+    const double stretch = std::cbrt(std::abs(Matrix4::determinant(placement)));
+    if (surface && stretch > 0) {
+        surface->scale /= stretch;
+    }
+    return surface;
+}
+
+Bounds Instance::getBounds() const
+{
+    return prototype->getBounds();
+}
+
+void Instance::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    RenderStats::local().instanceTests++;
+    size_t first = result.size();
+    prototype->intersects(Ray::transform(r, inversePlacement), result);
+    claimHits(result, first);
+}
+
+void Instance::intersectsToHit(const Ray & r, std::vector<Intersection>& result) const
+{
+    RenderStats::local().instanceTests++;
+    size_t first = result.size();
+    prototype->intersectsToHit(Ray::transform(r, inversePlacement), result);
+    claimHits(result, first);
+}
+
+bool Instance::occludes(const Ray & r, double maxT) const
+{
+    RenderStats::local().instanceTests++;
+    return prototype->occludes(Ray::transform(r, inversePlacement), maxT);
+}
+
+std::shared_ptr<const Shape> Instance::getPrototype() const
+{
+    return prototype;
+}
+
+Instance::Instance(const std::shared_ptr<Shape> &prototype) :
+    prototype(prototype),
+    placement(Matrix4::identity()),
+    inversePlacement(Matrix4::identity()),
+    placementNormalTransform(Matrix4::normalMatrix(Matrix4::identity())),
+    transform(prototype->getTransform()),
+    inverseTransform(prototype->getInverseTransform())
+{
+}
+
+Tuple Instance::toWorldNormal(const Tuple & prototypeNormal) const
+{
+    return Tuple::normalize(placementNormalTransform * prototypeNormal);
+}
+
+void Instance::claimHits(std::vector<Intersection>& result, size_t first) const
+{
+    // The prototype itself is never part of the world.
+    for (size_t i = first; i < result.size(); i++) {
+        const Intersection &hit = result[i];
+        result[i] = Intersection(hit.getT(), this, hit.getPrimitive(), hit.getU(), hit.getV());
+    }
+}
\ No newline at end of file
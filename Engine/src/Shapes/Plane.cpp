@@ -1,4 +1,6 @@
 #include <Shapes/Plane.h>
+#include <RenderStats.h>
+#include <cmath>
 
 static const double EPSILON = 0.000001;
 
@@ -12,18 +14,19 @@ bool Plane::operator==(const Shape & other) const
     return true;
 }
 
-void Plane::setTransform(const Matrix & m)
+void Plane::setTransform(const Matrix4 & m)
 {
     transform = m;
-    inverseTransform = Matrix::inverse(transform);
+    inverseTransform = Matrix4::inverse(transform);
+    worldNormal = Tuple::normalize(Matrix4::normalMatrix(inverseTransform) * Tuple::vector(0, 1, 0));
 }
 
-Matrix Plane::getTransform() const
+const Matrix4& Plane::getTransform() const
 {
     return transform;
 }
 
-Matrix Plane::getInverseTransform() const
+const Matrix4& Plane::getInverseTransform() const
 {
     return inverseTransform;
 }
@@ -38,31 +41,43 @@ Material & Plane::getMaterial()
     return material;
 }
 
-Material Plane::getMaterial() const
+const Material& Plane::getMaterial() const
 {
     return material;
 }
 
 Tuple Plane::normalAt(const Tuple & point) const
 {
-    Tuple worldNormal = Matrix::transpose(inverseTransform) * Tuple::vector(0, 1, 0);
-    worldNormal[3] = 0.0f;
-    return Tuple::normalize(worldNormal);
+    return worldNormal;
 }
 
-std::vector<Intersection> Plane::intersects(const Ray & r) const
+Bounds Plane::getBounds() const
 {
+    return Bounds::infinite();
+}
+
+void Plane::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    RenderStats::local().planeTests++;
      Ray ray = Ray::transform(r, inverseTransform);
-     std::vector<Intersection> result;
      
      if (abs(ray.direction[1]) >= EPSILON) {
          double t = -ray.origin[1] / ray.direction[1];
-         result.push_back(Intersection(t, shared_from_this()));
+         result.push_back(Intersection(t, this));
      }
+}
 
-     return result;
+void Plane::intersects(const RayPacket & packet, PacketHits & hits) const
+{
+    RenderStats::local().planeTests += packet.size;
+    RayPacket local = RayPacket::transform(packet, inverseTransform);
+    for (int i = 0; i < local.size; i++) {
+        if (std::abs(local.directionY[i]) >= EPSILON) {
+            hits.record(i, -local.originY[i] / local.directionY[i], this);
+        }
+    }
 }
 
-Plane::Plane() : transform(Matrix::getIdentity4x4()), inverseTransform(Matrix::getIdentity4x4()), material(Material::Material()) {
+Plane::Plane() : transform(Matrix4::identity()), inverseTransform(Matrix4::identity()), worldNormal(Tuple::vector(0, 1, 0)), material(Material::Material()) {
 
 }
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include <Shapes/Shape.h>
+
+Tuple Shape::normalAt(const Tuple & point, const Intersection & /*hit*/) const
+{
+    return normalAt(point);
+}
+
+std::optional<SurfaceUV> Shape::surfaceUVAt(const Intersection & /*hit*/) const
+{
+    return std::nullopt;
+}
+
+std::vector<Intersection> Shape::intersects(const Ray & r) const
+{
+    std::vector<Intersection> result;
+    intersects(r, result);
+    return result;
+}
+
+void Shape::intersectsToHit(const Ray & r, std::vector<Intersection>& result) const
+{
+    intersects(r, result);
+}
+
+bool Shape::occludes(const Ray & r, double maxT) const
+{
+    static thread_local std::vector<Intersection> buffer;
+    buffer.clear();
+    intersects(r, buffer);
+    for (const Intersection &i : buffer) {
+        if (i.getT() > 0 && i.getT() < maxT) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Shape::intersects(const RayPacket & packet, PacketHits & hits) const
+{
+    static thread_local std::vector<Intersection> buffer;
+    for (int lane = 0; lane < packet.size; lane++) {
+        buffer.clear();
+        intersectsToHit(packet.getRay(lane), buffer);
+        for (const Intersection &i : buffer) {
+            hits.record(lane, i);
+        }
+    }
+}
@@ -1,4 +1,6 @@
 #include <Shapes/Sphere.h>
+#include <RenderStats.h>
+#include <utility>
 
 std::shared_ptr<Sphere> Sphere::createSphere()
 {
@@ -18,18 +20,19 @@ bool Sphere::operator==(const Shape &other) const
     return true;
 }
 
-void Sphere::setTransform(const Matrix &m)
+void Sphere::setTransform(const Matrix4 &m)
 {
     transform = m;
-    inverseTransform = Matrix::inverse(transform);
+    inverseTransform = Matrix4::inverse(transform);
+    normalTransform = Matrix4::normalMatrix(inverseTransform);
 }
 
-Matrix Sphere::getTransform() const
+const Matrix4& Sphere::getTransform() const
 {
     return transform;
 }
 
-Matrix Sphere::getInverseTransform() const
+const Matrix4& Sphere::getInverseTransform() const
 {
     return inverseTransform;
 }
@@ -44,7 +47,7 @@ Material & Sphere::getMaterial()
     return material;
 }
 
-Material Sphere::getMaterial() const
+const Material& Sphere::getMaterial() const
 {
     return material;
 }
@@ -53,13 +56,17 @@ Tuple Sphere::normalAt(const Tuple & point) const
 {
     Tuple objectPoint = inverseTransform * point;
     Tuple objectNormal = Tuple::normalize(objectPoint - Tuple::point(0, 0, 0));
-    Tuple worldNormal = Matrix::transpose(inverseTransform) * objectNormal;
-    worldNormal[3] = 0.0f;
-    return Tuple::normalize(worldNormal);
+    return Tuple::normalize(normalTransform * objectNormal);
 }
 
-std::vector<Intersection> Sphere::intersects(const Ray & r) const
+Bounds Sphere::getBounds() const
 {
+    return Bounds(Tuple::point(-1, -1, -1), Tuple::point(1, 1, 1));
+}
+
+void Sphere::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    RenderStats::local().sphereTests++;
     Ray ray = Ray::transform(r, inverseTransform);
     Tuple sphereToRay = ray.origin - Tuple::point(0, 0, 0);
     double a = Tuple::dot(ray.direction, ray.direction);
@@ -68,19 +75,42 @@ std::vector<Intersection> Sphere::intersects(const Ray & r) const
 
     double discriminant = (b * b) - (4 * a * c);
 
-    if (discriminant < 0.0) {
-        return std::vector<Intersection>{};
-    }
-    else {
+    if (discriminant >= 0.0) {
         double t1 = (-b - sqrt(discriminant)) / (2 * a);
         double t2 = (-b + sqrt(discriminant)) / (2 * a);
+        if (t1 > t2) {
+            std::swap(t1, t2);
+        }
+
+        result.push_back(Intersection(t1, this));
+        result.push_back(Intersection(t2, this));
+    }
+}
+
+void Sphere::intersects(const RayPacket & packet, PacketHits & hits) const
+{
+    RenderStats::local().sphereTests += packet.size;
+    RayPacket local = RayPacket::transform(packet, inverseTransform);
+    for (int i = 0; i < local.size; i++) {
+        const Real ox = local.originX[i], oy = local.originY[i], oz = local.originZ[i];
+        const Real dx = local.directionX[i], dy = local.directionY[i], dz = local.directionZ[i];
+        const double a = dx * dx + dy * dy + dz * dz;
+        const double b = 2 * (dx * ox + dy * oy + dz * oz);
+        const double c = (ox * ox + oy * oy + oz * oz) - 1.0;
+        const double discriminant = (b * b) - (4 * a * c);
 
-        Intersection i1 = Intersection::Intersection(t1, shared_from_this());
-        Intersection i2 = Intersection::Intersection(t2, shared_from_this());
-        return i1.getT() > i2.getT() ? std::vector<Intersection>{i2, i1} : std::vector<Intersection>{ i1, i2 };
+        // Every lane does the same work, the misses are masked out at the end.
+        const double root = sqrt(discriminant >= 0.0 ? discriminant : 0.0);
+        const double t1 = (-b - root) / (2 * a);
+        const double t2 = (-b + root) / (2 * a);
+        const double near = t1 < t2 ? t1 : t2;
+        const double far = t1 < t2 ? t2 : t1;
+        if (discriminant >= 0.0) {
+            hits.record(i, near > 0 ? near : far, this);
+        }
     }
 }
 
-Sphere::Sphere() : transform(Matrix::getIdentity4x4()), inverseTransform(Matrix::getIdentity4x4()), material(Material::Material())
+Sphere::Sphere() : transform(Matrix4::identity()), inverseTransform(Matrix4::identity()), normalTransform(Matrix4::normalMatrix(Matrix4::identity())), material(Material::Material())
 {
 }
\ No newline at end of file
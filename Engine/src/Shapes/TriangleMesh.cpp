@@ -0,0 +1,330 @@
+#include <Shapes/TriangleMesh.h>
+#include <RenderStats.h>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+int MeshData::getTriangleCount() const
+{
+    return static_cast<int>(positionIndices.size() / 3);
+}
+
+static void checkIndices(const std::vector<int> &indices, size_t arraySize, int components, bool optional)
+{
+    for (int index : indices) {
+        if (optional && index == -1) {
+            continue;
+        }
+        if (index < 0 || static_cast<size_t>(index + 1) * components > arraySize) {
+            throw std::invalid_argument("mesh index out of range");
+        }
+    }
+}
+
+static void checkData(MeshData &data)
+{
+    if (data.positionIndices.size() % 3 != 0) {
+        throw std::invalid_argument("mesh needs three position indices per triangle");
+    }
+    if (data.normalIndices.empty()) {
+        data.normalIndices.assign(data.positionIndices.size(), -1);
+    }
+    if (data.uvIndices.empty()) {
+        data.uvIndices.assign(data.positionIndices.size(), -1);
+    }
+    if (data.normalIndices.size() != data.positionIndices.size() || data.uvIndices.size() != data.positionIndices.size()) {
+        throw std::invalid_argument("mesh needs as many normal and uv indices as position indices");
+    }
+    checkIndices(data.positionIndices, data.positions.size(), 3, false);
+    checkIndices(data.normalIndices, data.normals.size(), 3, true);
+    checkIndices(data.uvIndices, data.uvs.size(), 2, true);
+}
+
+std::shared_ptr<TriangleMesh> TriangleMesh::createTriangleMesh(MeshData data)
+{
+    checkData(data);
+
+    std::vector<Bounds> triangleBounds;
+    triangleBounds.reserve(data.getTriangleCount());
+    for (int triangle = 0; triangle < data.getTriangleCount(); triangle++) {
+        Bounds b;
+        for (int corner = 0; corner < 3; corner++) {
+            const double *p = &data.positions[3 * data.positionIndices[3 * triangle + corner]];
+            b.extend(Tuple::point(p[0], p[1], p[2]));
+        }
+        triangleBounds.push_back(b);
+    }
+
+    std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>();
+    geometry->bvh = BVH(triangleBounds);
+    geometry->data = std::move(data);
+    return std::make_shared<TriangleMesh>(TriangleMesh(geometry));
+}
+
+std::shared_ptr<TriangleMesh> TriangleMesh::createTriangleMesh(MeshData data, BVH bvh)
+{
+    checkData(data);
+
+    std::vector<bool> indexed(data.getTriangleCount(), false);
+    for (int triangle : bvh.getPrimitiveIndices()) {
+        if (triangle < 0 || triangle >= data.getTriangleCount() || indexed[triangle]) {
+            throw std::invalid_argument("mesh BVH does not match the triangles");
+        }
+        indexed[triangle] = true;
+    }
+    if (bvh.getPrimitiveIndices().size() != indexed.size()) {
+        throw std::invalid_argument("mesh BVH does not match the triangles");
+    }
+
+    std::shared_ptr<Geometry> geometry = std::make_shared<Geometry>();
+    geometry->bvh = std::move(bvh);
+    geometry->data = std::move(data);
+    return std::make_shared<TriangleMesh>(TriangleMesh(geometry));
+}
+
+bool TriangleMesh::operator==(const Shape & /*other*/) const
+{
+    return true;
+}
+
+void TriangleMesh::setTransform(const Matrix4 & m)
+{
+    transform = m;
+    inverseTransform = Matrix4::inverse(transform);
+    normalTransform = Matrix4::normalMatrix(inverseTransform);
+}
+
+const Matrix4& TriangleMesh::getTransform() const
+{
+    return transform;
+}
+
+const Matrix4& TriangleMesh::getInverseTransform() const
+{
+    return inverseTransform;
+}
+
+void TriangleMesh::setMaterial(const Material & m)
+{
+    material = m;
+}
+
+Material & TriangleMesh::getMaterial()
+{
+    return material;
+}
+
+const Material& TriangleMesh::getMaterial() const
+{
+    return material;
+}
+
+Tuple TriangleMesh::normalAt(const Tuple & /*point*/) const
+{
+    throw std::invalid_argument("triangle mesh normals need the intersection");
+}
+
+Tuple TriangleMesh::normalAt(const Tuple & /*point*/, const Intersection & hit) const
+{
+    const MeshData &data = geometry->data;
+    int triangle = hit.getPrimitive();
+    if (triangle < 0 || triangle >= data.getTriangleCount()) {
+        throw std::invalid_argument("intersection does not belong to a triangle of the mesh");
+    }
+
+    Tuple objectNormal = Tuple::vector(0, 0, 0);
+    const int *normalIndices = &data.normalIndices[3 * triangle];
+    if (normalIndices[0] >= 0 && normalIndices[1] >= 0 && normalIndices[2] >= 0) {
+        const double weights[3] = { 1.0 - hit.getU() - hit.getV(), hit.getU(), hit.getV() };
+        for (int corner = 0; corner < 3; corner++) {
+            const double *n = &data.normals[3 * normalIndices[corner]];
+            objectNormal = objectNormal + Tuple::vector(n[0], n[1], n[2]) * weights[corner];
+        }
+    }
+    else {
+        objectNormal = faceNormal(triangle);
+    }
+
+    return Tuple::normalize(normalTransform * objectNormal);
+}
+
+Bounds TriangleMesh::getBounds() const
+{
+    return geometry->bvh.getBounds();
+}
+
+void TriangleMesh::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    intersectTriangles(r, false, result);
+}
+
+void TriangleMesh::intersectsToHit(const Ray & r, std::vector<Intersection>& result) const
+{
+    intersectTriangles(r, true, result);
+}
+
+void TriangleMesh::intersectTriangles(const Ray & r, bool untilHit, std::vector<Intersection>& result) const
+{
+    double tMax = std::numeric_limits<double>::infinity();
+    traverseTriangles(Ray::transform(r, inverseTransform), -std::numeric_limits<double>::infinity(), tMax,
+        [&](int triangle, double t, double u, double v, double &tLimit) {
+            if (untilHit && t > 0) {
+                if (t > tLimit) {
+                    return false;
+                }
+                tLimit = t;
+            }
+            result.push_back(Intersection(t, this, triangle, u, v));
+            return false;
+        });
+}
+
+bool TriangleMesh::occludes(const Ray & r, double maxT) const
+{
+    // Transforming the ray keeps its parameterization, so maxT bounds the object space traversal as well.
+    bool blocked = false;
+    double tMax = maxT;
+    traverseTriangles(Ray::transform(r, inverseTransform), 0.0, tMax,
+        [&](int /*triangle*/, double t, double /*u*/, double /*v*/, double & /*tLimit*/) {
+            blocked = t > 0 && t < maxT;
+            return blocked;
+        });
+    return blocked;
+}
+
+template <typename OnHit>
+void TriangleMesh::traverseTriangles(const Ray & ray, double tMin, double & tMax, OnHit onHit) const
+{
+    RenderStats &stats = RenderStats::local();
+    stats.meshTests++;
+
+    // Watertight ray/triangle test (Woop, Benthin and Wald 2013). The ray is sheared so it runs along +z,
+    // then the edge functions are evaluated in 2D, so triangles sharing an edge can't both miss a ray through it.
+    int kz = 0;
+    for (int axis = 1; axis < 3; axis++) {
+        if (std::abs(ray.direction[axis]) > std::abs(ray.direction[kz])) {
+            kz = axis;
+        }
+    }
+    int kx = (kz + 1) % 3;
+    int ky = (kx + 1) % 3;
+    if (ray.direction[kz] < 0) {
+        std::swap(kx, ky);
+    }
+    if (ray.direction[kz] == 0) {
+        return;
+    }
+
+    const double shearX = ray.direction[kx] / ray.direction[kz];
+    const double shearY = ray.direction[ky] / ray.direction[kz];
+    const double shearZ = 1.0 / ray.direction[kz];
+
+    const MeshData &data = geometry->data;
+    auto intersectTriangle = [&](int triangle, double &tLimit) {
+        stats.triangleTests++;
+        double x[3], y[3], z[3];
+        for (int corner = 0; corner < 3; corner++) {
+            const double *p = &data.positions[3 * data.positionIndices[3 * triangle + corner]];
+            const double relative[3] = { p[0] - ray.origin[0], p[1] - ray.origin[1], p[2] - ray.origin[2] };
+            x[corner] = relative[kx] - shearX * relative[kz];
+            y[corner] = relative[ky] - shearY * relative[kz];
+            z[corner] = shearZ * relative[kz];
+        }
+
+        // Each edge function weighs the corner opposite to its edge.
+        const double u = x[2] * y[1] - y[2] * x[1];
+        const double v = x[0] * y[2] - y[0] * x[2];
+        const double w = x[1] * y[0] - y[1] * x[0];
+        if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) {
+            return false;
+        }
+
+        const double determinant = u + v + w;
+        if (determinant == 0) {
+            return false;
+        }
+
+        const double t = (u * z[0] + v * z[1] + w * z[2]) / determinant;
+        return onHit(triangle, t, v / determinant, w / determinant, tLimit);
+    };
+
+    geometry->bvh.traverse(ray, tMin, tMax, intersectTriangle);
+}
+
+int TriangleMesh::getTriangleCount() const
+{
+    return geometry->data.getTriangleCount();
+}
+
+const MeshData & TriangleMesh::getData() const
+{
+    return geometry->data;
+}
+
+const BVH & TriangleMesh::getBVH() const
+{
+    return geometry->bvh;
+}
+
+UV TriangleMesh::uvAt(const Intersection & hit) const
+{
+    const MeshData &data = geometry->data;
+    int triangle = hit.getPrimitive();
+    if (triangle < 0 || triangle >= data.getTriangleCount()) {
+        throw std::invalid_argument("intersection does not belong to a triangle of the mesh");
+    }
+
+    const int *uvIndices = &data.uvIndices[3 * triangle];
+    if (uvIndices[0] < 0 || uvIndices[1] < 0 || uvIndices[2] < 0) {
+        return UV{ 0, 0 };
+    }
+
+    const double weights[3] = { 1.0 - hit.getU() - hit.getV(), hit.getU(), hit.getV() };
+    UV result = { 0, 0 };
+    for (int corner = 0; corner < 3; corner++) {
+        const double *uv = &data.uvs[2 * uvIndices[corner]];
+        result.u += uv[0] * weights[corner];
+        result.v += uv[1] * weights[corner];
+    }
+    return result;
+}
+
+std::optional<SurfaceUV> TriangleMesh::surfaceUVAt(const Intersection & hit) const
+{
+    const UV uv = uvAt(hit);
+    const MeshData &data = geometry->data;
+    const int *uvIndices = &data.uvIndices[3 * hit.getPrimitive()];
+    if (uvIndices[0] < 0 || uvIndices[1] < 0 || uvIndices[2] < 0) {
+        return std::nullopt;
+    }
+
+    // The scale compares the area of the triangle in uv space with its area in the world.
+    const double *uv0 = &data.uvs[2 * uvIndices[0]];
+    const double *uv1 = &data.uvs[2 * uvIndices[1]];
+    const double *uv2 = &data.uvs[2 * uvIndices[2]];
+    const double uvArea = std::abs((uv1[0] - uv0[0]) * (uv2[1] - uv0[1]) - (uv2[0] - uv0[0]) * (uv1[1] - uv0[1])) / 2;
+    const Tuple a = transform * vertex(hit.getPrimitive(), 0);
+    const Tuple b = transform * vertex(hit.getPrimitive(), 1);
+    const Tuple c = transform * vertex(hit.getPrimitive(), 2);
+    const double worldArea = Tuple::magnitude(Tuple::cross(b - a, c - a)) / 2;
+    return SurfaceUV{ uv, worldArea > 0 ? sqrt(uvArea / worldArea) : 0.0 };
+}
+
+TriangleMesh::TriangleMesh(std::shared_ptr<const Geometry> geometry) :
+    geometry(geometry), transform(Matrix4::identity()), inverseTransform(Matrix4::identity()), normalTransform(Matrix4::normalMatrix(Matrix4::identity())), material(Material::Material())
+{
+}
+
+Tuple TriangleMesh::vertex(int triangle, int corner) const
+{
+    const MeshData &data = geometry->data;
+    const double *p = &data.positions[3 * data.positionIndices[3 * triangle + corner]];
+    return Tuple::point(p[0], p[1], p[2]);
+}
+
+Tuple TriangleMesh::faceNormal(int triangle) const
+{
+    Tuple a = vertex(triangle, 0);
+    return Tuple::normalize(Tuple::cross(vertex(triangle, 1) - a, vertex(triangle, 2) - a));
+}
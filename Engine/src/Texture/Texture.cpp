@@ -1,10 +1,13 @@
 #include <Texture/Texture.h>
+#include <RenderStats.h>
+#include <algorithm>
+#include <cmath>
 
 Texture::Texture(std::shared_ptr<Pattern> texture, std::shared_ptr<UVMapping> mapping) :
     texture(texture), 
     mapping(mapping),
-    transform(Matrix::getIdentity4x4()), 
-    inverseTransform(Matrix::getIdentity4x4())
+    transform(Matrix4::identity()), 
+    inverseTransform(Matrix4::identity())
 {
 }
 
@@ -13,25 +16,51 @@ std::shared_ptr<Texture> Texture::createTexture(std::shared_ptr<Pattern> texture
     return std::make_shared<Texture>(Texture(texture, mapping));
 }
 
-void Texture::setTransform(const Matrix & m)
+void Texture::setTransform(const Matrix4 & m)
 {
     transform = m;
-    inverseTransform = Matrix::inverse(transform);
+    inverseTransform = Matrix4::inverse(transform);
 }
 
-Matrix Texture::getTransform() const
+Matrix4 Texture::getTransform() const
 {
     return transform;;
 }
 
-Matrix Texture::getInverseTransform() const
+Matrix4 Texture::getInverseTransform() const
 {
     return inverseTransform;
 }
 
-Color Texture::atObject(const Matrix &inverseObjectTransform, const Tuple &point) const
+Color Texture::atObject(const Matrix4 &inverseObjectTransform, const Tuple &point, double footprint) const
 {
+    StageTimer timer(&RenderStats::textureSeconds);
     Tuple objectPoint = inverseObjectTransform * point;
     Tuple texturePoint = inverseTransform * objectPoint;
-    return texture->atUV(mapping->operator()(texturePoint));
+    const UV uv = mapping->operator()(texturePoint);
+    if (footprint <= 0 || !texture->usesFootprint()) {
+        return texture->atUV(uv);
+    }
+
+    // The footprint in uv units, by finite differences: how far the uv moves for a step of the footprint's width
+    // along each axis. Steps along the normal barely move it, so the largest of the three stands for the surface.
+    // Mappings wrap around, a difference of more than half the range is the short way round.
+    double uvFootprint = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        const Tuple step = Tuple::vector(axis == 0 ? footprint : 0, axis == 1 ? footprint : 0, axis == 2 ? footprint : 0);
+        const UV moved = mapping->operator()(texturePoint + inverseTransform * (inverseObjectTransform * step));
+        const double du = std::abs(moved.u - uv.u);
+        const double dv = std::abs(moved.v - uv.v);
+        uvFootprint = std::max({ uvFootprint, std::min(du, 1 - du), std::min(dv, 1 - dv) });
+    }
+    return texture->atUV(uv, uvFootprint);
+}
+
+Color Texture::atSurface(const SurfaceUV & surface, double footprint) const
+{
+    StageTimer timer(&RenderStats::textureSeconds);
+    if (footprint <= 0 || !texture->usesFootprint()) {
+        return texture->atUV(surface.uv);
+    }
+    return texture->atUV(surface.uv, footprint * surface.scale);
 }
\ No newline at end of file
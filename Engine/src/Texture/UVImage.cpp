@@ -1,16 +1,326 @@
 #include <Texture/UVImage.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
 
-UVImage::UVImage(std::shared_ptr<Canvas> canvas) : image(canvas) {}
+static size_t bytesPerTexel(UVImage::Format format)
+{
+    return format == UVImage::Format::UNORM8 ? 3 : 3 * sizeof(uint16_t);
+}
+
+// IEEE 754 binary16, rounded to nearest. Values beyond its range are clamped to the largest finite one, tiny ones
+// become subnormals or zero.
+static uint16_t toHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    const int biased = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (biased == 0xff) {
+        return sign | (mantissa != 0 ? 0x7e00 : 0x7bff);
+    }
+    const int exponent = biased - 127 + 15;
+    if (exponent >= 31) {
+        return sign | 0x7bff;
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const int shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) {
+            half++;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    uint32_t half = (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) {
+        half++;
+    }
+    return sign | static_cast<uint16_t>(std::min<uint32_t>(half, 0x7bff));
+}
+
+static float fromHalf(uint16_t half)
+{
+    const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    const int exponent = (half >> 10) & 0x1f;
+    const uint32_t mantissa = half & 0x3ff;
+
+    if (exponent == 0) {
+        const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign != 0 ? -magnitude : magnitude;
+    }
+    const uint32_t bits = sign | (exponent == 31 ? 0x7f800000 : static_cast<uint32_t>(exponent - 15 + 127) << 23) | (mantissa << 13);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// 8-bit image files decode to multiples of 1/255, which 8 bits store without loss.
+static bool fitsUnorm8(const Canvas &canvas)
+{
+    const float *data = canvas.data();
+    for (size_t i = 0; i < 3 * static_cast<size_t>(canvas.width) * canvas.height; i++) {
+        const float scaled = data[i] * 255.0f;
+        if (data[i] < 0 || data[i] > 1 || std::abs(scaled - std::round(scaled)) > 1e-3f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Texels of the previous level an output texel covers along one axis, with their share of it.
+struct FilterTaps {
+    int count;
+    int index[3];
+    float weight[3];
+};
+
+// Box filter over the exact span of every output texel. Halving an even size gives two taps of 1/2. An odd size
+// rounds down, so the output texels cover 2 + 1/size texels each and reach into a third one, which makes every texel
+// of the previous level count.
+static std::vector<FilterTaps> boxFilterTaps(int previousSize, int size)
+{
+    std::vector<FilterTaps> taps(size);
+    const double ratio = static_cast<double>(previousSize) / size;
+    for (int i = 0; i < size; i++) {
+        const double begin = i * ratio;
+        const double end = std::min((i + 1) * ratio, static_cast<double>(previousSize));
+        FilterTaps &tap = taps[i];
+        tap.count = 0;
+        for (int source = static_cast<int>(begin); source < end && tap.count < 3; source++) {
+            const double overlap = std::min(end, source + 1.0) - std::max(begin, static_cast<double>(source));
+            if (overlap > 1e-9) {
+                tap.index[tap.count] = source;
+                tap.weight[tap.count] = static_cast<float>(overlap / ratio);
+                tap.count++;
+            }
+        }
+    }
+    return taps;
+}
+
+UVImage::UVImage(int width, int height, Format format) : format(format)
+{
+    if (width < 1 || height < 1) {
+        throw std::invalid_argument("texture image needs at least one pixel");
+    }
+
+    size_t offset = 0;
+    while (true) {
+        const int tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        const int tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        levels.push_back(Level{ width, height, tilesX, offset });
+        offset += static_cast<size_t>(tilesX) * tilesY * TILE_SIZE * TILE_SIZE;
+        if (width == 1 && height == 1) {
+            break;
+        }
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+    texels.resize(offset * bytesPerTexel(format));
+}
+
+template <typename Fetch>
+void UVImage::build(Fetch fetch)
+{
+    const Level &full = levels[0];
+    for (int y = 0; y < full.height; y++) {
+        for (int x = 0; x < full.width; x++) {
+            float rgb[3];
+            fetch(x, y, rgb);
+            store(full, x, y, rgb);
+        }
+    }
+
+    // Every other level is a box filter of the one before, computed in float from the unrounded previous level:
+    // 2 x 2 texels for even sizes, up to 3 x 3 with fractional weights where the previous size is odd.
+    std::vector<float> current, next;
+    for (size_t l = 1; l < levels.size(); l++) {
+        const Level &previous = levels[l - 1];
+        const Level &level = levels[l];
+        const std::vector<FilterTaps> tapsX = boxFilterTaps(previous.width, level.width);
+        const std::vector<FilterTaps> tapsY = boxFilterTaps(previous.height, level.height);
+        next.assign(3 * static_cast<size_t>(level.width) * level.height, 0.0f);
+        for (int y = 0; y < level.height; y++) {
+            for (int x = 0; x < level.width; x++) {
+                float *sum = &next[3 * (static_cast<size_t>(y) * level.width + x)];
+                const FilterTaps &tapX = tapsX[x];
+                const FilterTaps &tapY = tapsY[y];
+                for (int dy = 0; dy < tapY.count; dy++) {
+                    for (int dx = 0; dx < tapX.count; dx++) {
+                        const int sourceX = tapX.index[dx];
+                        const int sourceY = tapY.index[dy];
+                        float rgb[3];
+                        if (l == 1) {
+                            fetch(sourceX, sourceY, rgb);
+                        }
+                        else {
+                            std::memcpy(rgb, &current[3 * (static_cast<size_t>(sourceY) * previous.width + sourceX)], sizeof(rgb));
+                        }
+                        const float weight = tapX.weight[dx] * tapY.weight[dy];
+                        for (int c = 0; c < 3; c++) {
+                            sum[c] += weight * rgb[c];
+                        }
+                    }
+                }
+                store(level, x, y, sum);
+            }
+        }
+        std::swap(current, next);
+    }
+}
+
+UVImage::UVImage(const Canvas &canvas) : UVImage(canvas.width, canvas.height, fitsUnorm8(canvas) ? Format::UNORM8 : Format::HALF)
+{
+    build([&](int x, int y, float *rgb) {
+        std::memcpy(rgb, canvas.data() + 3 * (static_cast<size_t>(y) * canvas.width + x), 3 * sizeof(float));
+    });
+}
+
+UVImage::UVImage(int width, int height, const uint8_t *rgb) : UVImage(width, height, Format::UNORM8)
+{
+    build([&](int x, int y, float *out) {
+        const uint8_t *pixel = rgb + 3 * (static_cast<size_t>(y) * width + x);
+        for (int c = 0; c < 3; c++) {
+            out[c] = pixel[c] * (1.0f / 255.0f);
+        }
+    });
+}
 
 std::shared_ptr<UVImage> UVImage::createUVImage(std::shared_ptr<Canvas> canvas)
 {
-    return std::make_shared<UVImage>(UVImage(canvas));
+    return std::make_shared<UVImage>(UVImage(*canvas));
+}
+
+std::shared_ptr<UVImage> UVImage::createUVImage(int width, int height, Format format, std::vector<uint8_t> texels)
+{
+    if (format != Format::UNORM8 && format != Format::HALF) {
+        throw std::invalid_argument("unknown texture format");
+    }
+    UVImage image = UVImage(width, height, format);
+    if (texels.size() != image.texels.size()) {
+        throw std::invalid_argument("texture texels don't match its size");
+    }
+    image.texels = std::move(texels);
+    return std::make_shared<UVImage>(std::move(image));
+}
+
+size_t UVImage::texelIndex(const Level & level, int x, int y) const
+{
+    // Coordinates are never negative, so unsigned arithmetic lets the divisions by the tile size become shifts.
+    const unsigned tx = static_cast<unsigned>(x), ty = static_cast<unsigned>(y);
+    const size_t tile = static_cast<size_t>(ty / TILE_SIZE) * level.tilesX + tx / TILE_SIZE;
+    return level.offset + tile * TILE_SIZE * TILE_SIZE + (ty % TILE_SIZE) * TILE_SIZE + tx % TILE_SIZE;
+}
+
+void UVImage::store(const Level & level, int x, int y, const float *rgb)
+{
+    uint8_t *texel = &texels[texelIndex(level, x, y) * bytesPerTexel(format)];
+    if (format == Format::UNORM8) {
+        for (int c = 0; c < 3; c++) {
+            // Rounds to nearest, the value is never negative after clamping.
+            texel[c] = static_cast<uint8_t>(255.0f * std::clamp(rgb[c], 0.0f, 1.0f) + 0.5f);
+        }
+        return;
+    }
+    const uint16_t half[3] = { toHalf(rgb[0]), toHalf(rgb[1]), toHalf(rgb[2]) };
+    std::memcpy(texel, half, sizeof(half));
+}
+
+Color UVImage::texel(int level, int x, int y) const
+{
+    const uint8_t *texel = &texels[texelIndex(levels[level], x, y) * bytesPerTexel(format)];
+    if (format == Format::UNORM8) {
+        const double scale = 1.0 / 255.0;
+        return Color(texel[0] * scale, texel[1] * scale, texel[2] * scale);
+    }
+    uint16_t rgb[3];
+    std::memcpy(rgb, texel, sizeof(rgb));
+    return Color(fromHalf(rgb[0]), fromHalf(rgb[1]), fromHalf(rgb[2]));
+}
+
+Color UVImage::bilinear(int level, const UV & uv) const
+{
+    const Level &l = levels[level];
+    const double x = std::clamp(uv.u * l.width - 0.5, 0.0, l.width - 1.0);
+    const double y = std::clamp((1 - uv.v) * l.height - 0.5, 0.0, l.height - 1.0);
+    const int x0 = static_cast<int>(x);
+    const int y0 = static_cast<int>(y);
+    const int x1 = std::min(x0 + 1, l.width - 1);
+    const int y1 = std::min(y0 + 1, l.height - 1);
+    const double fx = x - x0;
+    const double fy = y - y0;
+
+    const Color top = texel(level, x0, y0) * (1 - fx) + texel(level, x1, y0) * fx;
+    const Color bottom = texel(level, x0, y1) * (1 - fx) + texel(level, x1, y1) * fx;
+    return top * (1 - fy) + bottom * fy;
 }
 
 Color UVImage::atUV(const UV & uv) const
 {
-    double v = 1 - uv.v;
-    double x = uv.u * (image->width - 1);
-    double y = v * (image->height - 1);
-    return image->at(static_cast<int>(round(x)), static_cast<int>(round(y)));
+    return bilinear(0, uv);
+}
+
+Color UVImage::atUV(const UV & uv, double footprint) const
+{
+    // The level whose texels are as wide as the footprint, fractional in between two levels.
+    const double lod = std::log2(footprint * std::max(getWidth(), getHeight()));
+    if (!(lod > 0)) {
+        return bilinear(0, uv);
+    }
+    const int last = getLevelCount() - 1;
+    if (lod >= last) {
+        return bilinear(last, uv);
+    }
+
+    const int level = static_cast<int>(lod);
+    const double blend = lod - level;
+    return bilinear(level, uv) * (1 - blend) + bilinear(level + 1, uv) * blend;
+}
+
+bool UVImage::usesFootprint() const
+{
+    return true;
+}
+
+int UVImage::getWidth() const
+{
+    return levels[0].width;
+}
+
+int UVImage::getHeight() const
+{
+    return levels[0].height;
+}
+
+UVImage::Format UVImage::getFormat() const
+{
+    return format;
+}
+
+int UVImage::getLevelCount() const
+{
+    return static_cast<int>(levels.size());
+}
+
+int UVImage::getLevelWidth(int level) const
+{
+    return levels[level].width;
+}
+
+int UVImage::getLevelHeight(int level) const
+{
+    return levels[level].height;
+}
+
+const std::vector<uint8_t>& UVImage::getTexels() const
+{
+    return texels;
 }
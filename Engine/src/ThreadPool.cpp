@@ -0,0 +1,113 @@
+#include <ThreadPool.h>
+
+ThreadPool::ThreadPool(int threadCount) : nextQueue(0), queuedTasks(0), pendingTasks(0), stopping(false)
+{
+    int count = resolveThreadCount(threadCount);
+    for (int i = 0; i < count; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 0; i < count; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+int ThreadPool::resolveThreadCount(int requested)
+{
+    if (requested > 0) {
+        return requested;
+    }
+    unsigned int hardware = std::thread::hardware_concurrency();
+    return hardware == 0 ? 1 : static_cast<int>(hardware);
+}
+
+int ThreadPool::getThreadCount() const
+{
+    return static_cast<int>(workers.size());
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    int index = nextQueue.fetch_add(1) % static_cast<int>(queues.size());
+    // Count the task before it becomes visible, otherwise a worker could finish it and let wait() return early.
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        queuedTasks++;
+        pendingTasks++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allDone.wait(lock, [this]() { return pendingTasks == 0; });
+}
+
+bool ThreadPool::popTask(int index, std::function<void()> &task)
+{
+    {
+        WorkQueue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    int count = static_cast<int>(queues.size());
+    for (int offset = 1; offset < count; offset++) {
+        WorkQueue &victim = *queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    while (true) {
+        std::function<void()> task;
+        if (popTask(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queuedTasks--;
+            }
+            task();
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pendingTasks == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        if (stopping) {
+            return;
+        }
+        workAvailable.wait(lock, [this]() { return stopping || queuedTasks > 0; });
+        if (stopping) {
+            return;
+        }
+    }
+}
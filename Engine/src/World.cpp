@@ -1,8 +1,30 @@
 #include <World.h>
 #include <Shapes/Sphere.h>
+#include <Sampling.h>
 #include <algorithm>
+#include <limits>
 
-World::World()
+// Per-thread buffer for the intersection queries made while shading, it keeps its capacity between rays.
+static std::vector<Intersection>& scratchIntersections()
+{
+    static thread_local std::vector<Intersection> buffer;
+    return buffer;
+}
+
+std::vector<World::QueuedRay>& World::scratchQueue(int generation)
+{
+    static thread_local std::vector<QueuedRay> buffers[2];
+    return buffers[generation];
+}
+
+// Per-thread buffer for the light weights of sampledLighting().
+static std::vector<double>& scratchWeights()
+{
+    static thread_local std::vector<double> buffer;
+    return buffer;
+}
+
+World::World() : lightSamples(0), maxBounces(MAX_REFLECTION_BOUNCES), rouletteThreshold(0), pixelSpread(0), accelerated(false)
 {
 }
 
@@ -13,7 +35,7 @@ World World::makeDefaultWorld()
     std::shared_ptr<Sphere> s1 = Sphere::createSphere();
     s1->setMaterial(Material(Color(0.8, 1.0, 0.6), 0.1, 0.7, 0.2, 200, 0, 0, 1));
     std::shared_ptr<Sphere> s2 = Sphere::createSphere();
-    s2->setTransform(Matrix::scaling(0.5, 0.5, 0.5));
+    s2->setTransform(Matrix4::scaling(0.5, 0.5, 0.5));
     w.addObject(s1);
     w.addObject(s2);
     return w;
@@ -54,6 +76,46 @@ AreaLight World::getAreaLight(int index) const
     return areaLights[index];
 }
 
+void World::setLightSamples(int count)
+{
+    lightSamples = count;
+}
+
+int World::getLightSamples() const
+{
+    return lightSamples;
+}
+
+void World::setMaxBounces(int bounces)
+{
+    maxBounces = bounces;
+}
+
+int World::getMaxBounces() const
+{
+    return maxBounces;
+}
+
+void World::setRouletteThreshold(double threshold)
+{
+    rouletteThreshold = threshold;
+}
+
+double World::getRouletteThreshold() const
+{
+    return rouletteThreshold;
+}
+
+void World::setPixelSpread(double spread)
+{
+    pixelSpread = spread;
+}
+
+double World::getPixelSpread() const
+{
+    return pixelSpread;
+}
+
 int World::getObjectCount() const
 {
     return (int) objects.size();
@@ -62,68 +124,439 @@ int World::getObjectCount() const
 void World::addObject(const std::shared_ptr<Shape> &object)
 {
     objects.push_back(object);
+    if (accelerated) {
+        accelerated = false;
+        bvh = BVH();
+        boundedObjects.clear();
+        unboundedObjects.clear();
+    }
 }
+
 std::shared_ptr<Shape> World::getObject(int index) const
 {
     return objects[index];
 }
 
+void World::buildAccelerationStructure()
+{
+    boundedObjects.clear();
+    unboundedObjects.clear();
+
+    std::vector<Bounds> bounds;
+    for (const auto &object : objects)
+    {
+        Bounds worldBounds = Bounds::transform(object->getBounds(), object->getTransform());
+        if (worldBounds.isEmpty())
+        {
+            // Nothing to hit, e.g. a mesh without triangles.
+            continue;
+        }
+        else if (worldBounds.isInfinite())
+        {
+            unboundedObjects.push_back(object);
+        }
+        else
+        {
+            boundedObjects.push_back(object);
+            bounds.push_back(worldBounds);
+        }
+    }
+
+    bvh = BVH(bounds);
+    accelerated = true;
+}
+
+bool World::hasAccelerationStructure() const
+{
+    return accelerated;
+}
+
 std::vector<Intersection> World::intersects(const Ray & r) const
 {
     std::vector<Intersection> result;
-    for (const auto &s : objects) 
+    collectIntersections(r, false, result);
+    return result;
+}
+
+std::vector<Intersection> World::intersectsToHit(const Ray & r) const
+{
+    std::vector<Intersection> result;
+    collectIntersections(r, true, result);
+    return result;
+}
+
+void World::intersects(const Ray & r, std::vector<Intersection>& result) const
+{
+    result.clear();
+    collectIntersections(r, false, result);
+}
+
+void World::intersectsToHit(const Ray & r, std::vector<Intersection>& result) const
+{
+    result.clear();
+    collectIntersections(r, true, result);
+}
+
+void World::collectIntersections(const Ray & r, bool untilHit, std::vector<Intersection>& result) const
+{
+    double closest = std::numeric_limits<double>::infinity();
+    auto append = [&](const Shape &shape) {
+        size_t first = result.size();
+        if (untilHit)
+        {
+            shape.intersectsToHit(r, result);
+        }
+        else
+        {
+            shape.intersects(r, result);
+        }
+        for (size_t i = first; i < result.size(); i++)
+        {
+            if (result[i].getT() > 0 && result[i].getT() < closest)
+            {
+                closest = result[i].getT();
+            }
+        }
+    };
+
+    if (!accelerated)
     {
-        for (Intersection i : s->intersects(r)) 
+        for (const auto &s : objects)
         {
-            result.push_back(i);
+            append(*s);
         }
     }
+    else
+    {
+        for (const auto &s : unboundedObjects)
+        {
+            append(*s);
+        }
+
+        // Looking for the hit lets the traversal skip everything behind the ray origin or past the closest hit so far.
+        // Shapes entirely behind the origin enter and leave the refraction containers before the hit, so they don't matter.
+        double tMin = untilHit ? 0.0 : -std::numeric_limits<double>::infinity();
+        double tMax = std::numeric_limits<double>::infinity();
+        bvh.traverse(r, tMin, tMax, [&](int index, double &tLimit) {
+            append(*boundedObjects[index]);
+            if (untilHit)
+            {
+                tLimit = std::min(tLimit, closest);
+            }
+            return false;
+        });
+    }
+
+    if (untilHit)
+    {
+        result.erase(std::remove_if(result.begin(), result.end(), [closest](const Intersection &i) {
+            return i.getT() > closest;
+        }), result.end());
+    }
 
-    sort(result.begin(), result.end(), [](const Intersection i1, const Intersection i2) {
+    sort(result.begin(), result.end(), [](const Intersection &i1, const Intersection &i2) {
         return i1.getT() < i2.getT();
     });
+}
+
+void World::intersects(const RayPacket & packet, PacketHits & hits) const
+{
+    if (!accelerated)
+    {
+        for (const auto &s : objects)
+        {
+            s->intersects(packet, hits);
+        }
+        return;
+    }
 
-    return result;;
+    for (const auto &s : unboundedObjects)
+    {
+        s->intersects(packet, hits);
+    }
+
+    bvh.traverse(packet, hits.t, [&](int index) {
+        boundedObjects[index]->intersects(packet, hits);
+    });
 }
 
-Color World::shadeHit(Hit hit, int remainingBounces) const
+Color World::shadeHit(const Hit &hit, int remainingBounces) const
 {
-    Color surface = Color(0, 0, 0);
-    
-    const Material material = hit.getObject()->getMaterial();
+    Color result = surfaceColor(hit, 0);
 
-    for (const auto &pointLight : pointLights) 
+    std::vector<QueuedRay> &queue = scratchQueue(0);
+    queue.clear();
+    queueSecondaryRays(hit, Color::white, 0, remainingBounces, 0, queue);
+    trace(queue, &result, false);
+    return result;
+}
+
+Color World::surfaceColor(const Hit &hit, double distance) const
+{
+    StageTimer timer(&RenderStats::shadeHitSeconds);
+    const Material &material = hit.getObject()->getMaterial();
+    // The pixel's cone grows linearly along the path, curved mirrors and lenses are not accounted for.
+    const double footprint = pixelSpread * (distance + hit.getT());
+    const std::optional<SurfaceUV> surfaceUV = material.texture ? hit.getObject()->surfaceUVAt(hit) : std::nullopt;
+
+    if (lightSamples > 0 && lightSamples < getLightCount())
+    {
+        return sampledLighting(hit, material, footprint, surfaceUV);
+    }
+
+    Color surface = Color(0, 0, 0);
+    for (const auto &pointLight : pointLights)
     {
         double intensity = intensityAt(pointLight, hit.overPoint);
         surface = surface + material.lighting(
-            hit.getObject()->getInverseTransform(), pointLight, hit.overPoint, hit.eyev, hit.normalv, intensity
+            hit.getObject()->getInverseTransform(), pointLight, hit.overPoint, hit.eyev, hit.normalv, intensity, footprint, surfaceUV
         );
     }
 
-    
-    for (const auto &areaLight : areaLights) 
+    for (const auto &areaLight : areaLights)
     {
         double intensity = intensityAt(areaLight, hit.overPoint);
         surface = surface + material.lighting(
-            hit.getObject()->getInverseTransform(), areaLight, hit.overPoint, hit.eyev, hit.normalv, intensity
+            hit.getObject()->getInverseTransform(), areaLight, hit.overPoint, hit.eyev, hit.normalv, intensity, footprint, surfaceUV
         );
     }
-    
-    Color reflected = reflectedColor(hit, remainingBounces);
-    Color refracted = refractedColor(hit, remainingBounces);
+    return surface;
+}
 
-    Color result;
+// Snell's law at the hit, nothing on total internal reflection.
+static std::optional<Ray> refractionRay(const Hit &hit)
+{
+    double ratio = hit.n1 / hit.n2;
+    double cos_i = Tuple::dot(hit.eyev, hit.normalv);
+    double sin2_t = ratio * ratio * (1 - cos_i * cos_i);
+    if (sin2_t > 1.0)
+    {
+        return std::nullopt;
+    }
+
+    double cos_t = sqrt(1.0 - sin2_t);
+    Tuple direction = hit.normalv * (ratio * cos_i - cos_t) - hit.eyev * ratio;
+    return Ray(hit.underPoint, direction);
+}
+
+void World::queueSecondaryRays(const Hit &hit, const Color &weight, int pixel, int remainingBounces, double distance, std::vector<QueuedRay> &queue) const
+{
+    const Material &material = hit.getObject()->getMaterial();
+    if (remainingBounces < 1)
+    {
+        return;
+    }
+
+    // Surfaces that both reflect and refract split the light between the two by the Fresnel term.
+    double reflectWeight = material.reflective;
+    double refractWeight = material.transparency;
     if (material.reflective > 0 && material.transparency > 0)
     {
         double reflectance = hit.schlick();
-        result = surface + reflected * reflectance + refracted * (1 - reflectance);
-    } 
-    else
+        reflectWeight *= reflectance;
+        refractWeight *= 1 - reflectance;
+    }
+
+    // The random numbers are seeded from the hit, like the light samples, so renders stay repeatable.
+    std::optional<Sampling::Pcg32> generator;
+    auto survives = [&](Color &rayWeight) {
+        const double strength = std::max({ rayWeight.red, rayWeight.green, rayWeight.blue });
+        if (strength >= rouletteThreshold)
+        {
+            return true;
+        }
+        if (!generator.has_value())
+        {
+            generator.emplace(Sampling::hash(hit.overPoint), 2);
+        }
+        if (generator->nextDouble() * rouletteThreshold < strength)
+        {
+            rayWeight = rayWeight * (rouletteThreshold / strength);
+            return true;
+        }
+        RenderStats::local().terminatedRays++;
+        return false;
+    };
+
+    if (material.reflective != 0.0)
     {
-        result = surface + reflected + refracted;
+        Color rayWeight = weight * reflectWeight;
+        if (survives(rayWeight))
+        {
+            RenderStats::local().reflectionRays++;
+            queue.push_back(QueuedRay{ Ray(hit.overPoint, hit.reflectv), rayWeight, pixel, remainingBounces - 1, distance + hit.getT() });
+        }
     }
 
-    return result;
+    if (material.transparency != 0.0)
+    {
+        std::optional<Ray> refractRay = refractionRay(hit);
+        Color rayWeight = weight * refractWeight;
+        if (refractRay.has_value() && survives(rayWeight))
+        {
+            RenderStats::local().refractionRays++;
+            queue.push_back(QueuedRay{ refractRay.value(), rayWeight, pixel, remainingBounces - 1, distance + hit.getT() });
+        }
+    }
+}
+
+void World::trace(std::vector<QueuedRay> &queue, Color *result, bool packets) const
+{
+    std::vector<QueuedRay> &next = scratchQueue(1);
+    // The buffer is free again once prepareHit() is done, so shading can reuse it for shadow rays.
+    std::vector<Intersection> &intersections = scratchIntersections();
+    auto shade = [&](const Hit &hit, const QueuedRay &queued) {
+        result[queued.pixel] = result[queued.pixel] + surfaceColor(hit, queued.distance) * queued.weight;
+        queueSecondaryRays(hit, queued.weight, queued.pixel, queued.remainingBounces, queued.distance, next);
+    };
+    auto traceAlone = [&](const QueuedRay &queued) {
+        intersectsToHit(queued.ray, intersections);
+        std::optional<Intersection> hit = Intersection::hit(intersections);
+        if (hit.has_value())
+        {
+            shade(hit.value().prepareHit(queued.ray, intersections), queued);
+        }
+    };
+
+    while (!queue.empty())
+    {
+        next.clear();
+        const size_t batch = packets ? RayPacket::MAX_SIZE : 1;
+        for (size_t first = 0; first < queue.size(); first += batch)
+        {
+            const size_t last = std::min(first + batch, queue.size());
+            if (last - first == 1)
+            {
+                traceAlone(queue[first]);
+                continue;
+            }
+
+            RayPacket packet;
+            for (size_t i = first; i < last; i++)
+            {
+                packet.add(queue[i].ray);
+            }
+            PacketHits hits;
+            intersects(packet, hits);
+
+            for (int lane = 0; lane < packet.size; lane++)
+            {
+                const QueuedRay &queued = queue[first + lane];
+                if (hits.object[lane] == nullptr)
+                {
+                    continue;
+                }
+                if (hits.object[lane]->getMaterial().transparency > 0.0)
+                {
+                    // Refractive indices depend on every surface the ray crossed before the hit, which only the single ray query collects.
+                    traceAlone(queued);
+                    continue;
+                }
+
+                // n1 and n2 are only read for transparent materials, so the hit alone is enough for prepareHit().
+                Intersection hit = hits.getIntersection(lane);
+                intersections.clear();
+                intersections.push_back(hit);
+                shade(hit.prepareHit(packet.getRay(lane), intersections), queued);
+            }
+        }
+        std::swap(queue, next);
+    }
+}
+
+static double brightness(const Color &c)
+{
+    return (c.red + c.green + c.blue) / 3.0;
+}
+
+// Estimated share of a light in the direct lighting at point: its brightness times the cosine towards it. Lights
+// don't fall off with distance in this renderer, so the cosine is all the geometry there is to weigh. The weight is
+// only 0 for lights entirely behind the surface, which can't contribute anything.
+static double lightWeight(const PointLight &light, const Tuple &point, const Tuple &normal)
+{
+    const double cosine = Tuple::dot(Tuple::normalize(light.position - point), normal);
+    return brightness(light.intensity) * std::max(cosine, 0.0);
+}
+
+// Averages the cosine over the corners and the center. The side of the surface a position lies on is linear in
+// the position, so when every corner is behind the surface the whole light is.
+static double lightWeight(const AreaLight &light, const Tuple &point, const Tuple &normal)
+{
+    const Tuple u = light.uVec * light.uSteps;
+    const Tuple v = light.vVec * light.vSteps;
+    const Tuple positions[5] = {
+        light.center, light.lowerLeftCorner, light.lowerLeftCorner + u, light.lowerLeftCorner + v, light.lowerLeftCorner + u + v
+    };
+
+    double cosine = 0.0;
+    for (const Tuple &position : positions) {
+        cosine += std::max<double>(Tuple::dot(Tuple::normalize(position - point), normal), 0.0);
+    }
+    return brightness(light.intensity) * cosine / 5;
+}
+
+Color World::sampledLighting(const Hit &hit, const Material &material, double footprint, const std::optional<SurfaceUV> &surfaceUV) const
+{
+    const Matrix4 &inverseTransform = hit.getObject()->getInverseTransform();
+
+    // Ambient light casts no shadow rays, so every light adds its share of it.
+    Color totalIntensity = Color::black;
+    for (const PointLight &light : pointLights) {
+        totalIntensity = totalIntensity + light.intensity;
+    }
+    for (const AreaLight &light : areaLights) {
+        totalIntensity = totalIntensity + light.intensity;
+    }
+    Color surface = material.ambientLighting(inverseTransform, totalIntensity, hit.overPoint, footprint, surfaceUV);
+
+    std::vector<double> &weights = scratchWeights();
+    weights.clear();
+    double total = 0.0;
+    for (const PointLight &light : pointLights) {
+        weights.push_back(lightWeight(light, hit.overPoint, hit.normalv));
+        total += weights.back();
+    }
+    for (const AreaLight &light : areaLights) {
+        weights.push_back(lightWeight(light, hit.overPoint, hit.normalv));
+        total += weights.back();
+    }
+    if (total <= 0.0) {
+        return surface;
+    }
+
+    // Systematic sampling: lightSamples evenly spaced positions behind one random offset walk the cumulative weights.
+    // A light gets about lightSamples * weight / total picks, so the bright ones can't be missed by chance. Its
+    // contribution is multiplied by picks / (lightSamples * weight / total), which keeps the expected color unchanged.
+    // The offset is seeded from the point, like the area light samples, so renders stay repeatable.
+    Sampling::Pcg32 generator(Sampling::hash(hit.overPoint), 1);
+    const double step = total / lightSamples;
+    double next = generator.nextDouble() * step;
+    double cumulative = 0.0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        cumulative += weights[i];
+        int picks = 0;
+        while (next < cumulative) {
+            picks++;
+            next += step;
+        }
+        if (picks == 0) {
+            continue;
+        }
+
+        const double scale = picks * step / weights[i];
+        if (i < pointLights.size()) {
+            const PointLight &light = pointLights[i];
+            const double intensity = intensityAt(light, hit.overPoint);
+            surface = surface + material.directLighting(inverseTransform, light, hit.overPoint, hit.eyev, hit.normalv, intensity, footprint, surfaceUV) * scale;
+        }
+        else {
+            const AreaLight &light = areaLights[i - pointLights.size()];
+            const double intensity = intensityAt(light, hit.overPoint);
+            surface = surface + material.directLighting(inverseTransform, light, hit.overPoint, hit.eyev, hit.normalv, intensity, footprint, surfaceUV) * scale;
+        }
+    }
+
+    return surface;
 }
 
 bool World::isShadowed(const Tuple &lightPosition, const Tuple &point) const
@@ -132,11 +565,40 @@ bool World::isShadowed(const Tuple &lightPosition, const Tuple &point) const
     double distance = Tuple::magnitude(v);
     Tuple direction = Tuple::normalize(v);
 
-    Ray ray = Ray(point, direction);
-    std::vector<Intersection> intersections = intersects(ray);
-    std::optional<Intersection> hit = Intersection::hit(intersections);
-    
-    return hit.has_value() && (hit.value().getT() < distance);
+    return occluded(Ray(point, direction), distance);
+}
+
+bool World::occluded(const Ray & r, double maxT) const
+{
+    RenderStats::local().shadowRays++;
+
+    if (!accelerated)
+    {
+        for (const auto &s : objects)
+        {
+            if (s->occludes(r, maxT))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    for (const auto &s : unboundedObjects)
+    {
+        if (s->occludes(r, maxT))
+        {
+            return true;
+        }
+    }
+
+    bool found = false;
+    double tMax = maxT;
+    bvh.traverse(r, 0.0, tMax, [&](int index, double & /*tLimit*/) {
+        found = boundedObjects[index]->occludes(r, maxT);
+        return found;
+    });
+    return found;
 }
 
 double World::intensityAt(const PointLight & light, const Tuple & point) const
@@ -146,21 +608,28 @@ double World::intensityAt(const PointLight & light, const Tuple & point) const
 
 double World::intensityAt(const AreaLight & light, const Tuple & point) const
 {
+    if (light.probeCount() > 0) {
+        const bool shadowed = isShadowed(light.probePosition(0), point);
+        bool agree = true;
+        for (int i = 1; i < light.probeCount() && agree; i++) {
+            agree = isShadowed(light.probePosition(i), point) == shadowed;
+        }
+        if (agree) {
+            return shadowed ? 0.0 : 1.0;
+        }
+    }
+
     double total = 0.0;
 
-    for (int u = 0; u < light.uSteps; u++) 
-    {
-        for (int v = 0; v < light.vSteps; v++) 
-        {
-            Tuple lightPosition = light.sample(u, v);
-            total = isShadowed(lightPosition, point) ? total : (total + 1.0);
-        }
+    for (int i = 0; i < light.samples; i++) {
+        Tuple lightPosition = light.samplePosition(i, point);
+        total = isShadowed(lightPosition, point) ? total : (total + 1.0);
     }
 
     return total / light.samples;
 }
 
-Color World::reflectedColor(Hit hit, int remainingBounces) const
+Color World::reflectedColor(const Hit &hit, int remainingBounces) const
 {
     if (remainingBounces < 1 || hit.getObject()->getMaterial().reflective == 0.0) 
     {
@@ -168,46 +637,58 @@ Color World::reflectedColor(Hit hit, int remainingBounces) const
     }
 
     Ray reflectRay = Ray(hit.overPoint, hit.reflectv);
+    RenderStats::local().reflectionRays++;
     Color color = colorAt(reflectRay, remainingBounces - 1);
     return color * hit.getObject()->getMaterial().reflective;
 }
 
-Color World::refractedColor(Hit hit, int remainingBounces) const
+Color World::refractedColor(const Hit &hit, int remainingBounces) const
 {
     if (remainingBounces < 1 || hit.getObject()->getMaterial().transparency == 0.0) 
     {
         return Color::black;
     }
 
-    double ratio = hit.n1 / hit.n2;
-    double cos_i = Tuple::dot(hit.eyev, hit.normalv);
-    double sin2_t = ratio * ratio * (1 - cos_i * cos_i);
-    if (sin2_t > 1.0) 
+    std::optional<Ray> refractRay = refractionRay(hit);
+    if (!refractRay.has_value()) 
     {
         return Color::black;
     }
+    RenderStats::local().refractionRays++;
 
-    double cos_t = sqrt(1.0 - sin2_t);
-    Tuple direction = hit.normalv * (ratio * cos_i - cos_t) - hit.eyev * ratio;
-    Ray refractRay = Ray(hit.underPoint, direction);
-
-    Color color = colorAt(refractRay, remainingBounces - 1);
+    Color color = colorAt(refractRay.value(), remainingBounces - 1);
     return color * hit.getObject()->getMaterial().transparency;
 }
 
+Color World::colorAt(const Ray & r) const
+{
+    return colorAt(r, maxBounces);
+}
 
 Color World::colorAt(const Ray & r, int remainingBounces) const
 {
-    std::vector<Intersection> intersections = intersects(r);
-    std::optional<Intersection> hit = Intersection::hit(intersections);
-    
-    if (hit.has_value()) 
-    {
-        Hit h = hit.value().prepareHit(r, intersections);
-        return shadeHit(h, remainingBounces);
-    }
-    else 
+    std::vector<QueuedRay> &queue = scratchQueue(0);
+    queue.clear();
+    queue.push_back(QueuedRay{ r, Color::white, 0, remainingBounces, 0 });
+
+    Color result = Color::black;
+    trace(queue, &result, false);
+    return result;
+}
+
+void World::colorAt(const RayPacket & packet, Color * result) const
+{
+    colorAt(packet, result, maxBounces);
+}
+
+void World::colorAt(const RayPacket & packet, Color * result, int remainingBounces) const
+{
+    std::vector<QueuedRay> &queue = scratchQueue(0);
+    queue.clear();
+    for (int lane = 0; lane < packet.size; lane++)
     {
-        return Color::black;
+        result[lane] = Color::black;
+        queue.push_back(QueuedRay{ packet.getRay(lane), Color::white, lane, remainingBounces, 0 });
     }
-}
\ No newline at end of file
+    trace(queue, result, true);
+}
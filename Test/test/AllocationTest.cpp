@@ -0,0 +1,150 @@
+#include <catch.hpp>
+#include <World.h>
+#include <Shapes/Sphere.h>
+#include <Shapes/Plane.h>
+#include <Shapes/Cube.h>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation made by the test binary goes through here, so a test can count the allocations
+// made by the code it exercises on the current thread.
+static thread_local long allocationCount = 0;
+
+void* operator new(std::size_t size)
+{
+    allocationCount++;
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+// The aligned overloads place the block inside a plain malloc() and keep the start of that allocation just before it,
+// so every pointer handed to free() is one malloc() returned, on every platform.
+static void* allocateAligned(std::size_t size, std::size_t alignment)
+{
+    void* allocation = std::malloc(size + alignment + sizeof(void*));
+    if (allocation == nullptr) {
+        return nullptr;
+    }
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(allocation) + sizeof(void*);
+    void** pointer = reinterpret_cast<void**>((first + alignment - 1) / alignment * alignment);
+    pointer[-1] = allocation;
+    return pointer;
+}
+
+static void freeAligned(void* pointer)
+{
+    if (pointer != nullptr) {
+        std::free(static_cast<void**>(pointer)[-1]);
+    }
+}
+
+// Types aligned beyond __STDCPP_DEFAULT_NEW_ALIGNMENT__, such as Tuple, Ray and the queued rays of World, come through
+// the aligned overloads instead.
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    allocationCount++;
+    void* pointer = allocateAligned(size == 0 ? 1 : size, static_cast<std::size_t>(alignment));
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer, std::align_val_t) noexcept
+{
+    freeAligned(pointer);
+}
+
+void operator delete(void* pointer, std::size_t, std::align_val_t alignment) noexcept
+{
+    operator delete(pointer, alignment);
+}
+
+static World makeAllocationTestWorld()
+{
+    World w = World::makeDefaultWorld();
+    w.addLight(AreaLight(Color(1, 1, 1), Tuple::point(-1, 4, -4), Tuple::vector(2, 0, 0), 2, Tuple::vector(0, 2, 0), 2, true));
+
+    std::shared_ptr<Plane> floor = Plane::createPlane();
+    floor->setTransform(Matrix4::translation(0, -1, 0));
+    floor->getMaterial().reflective = 0.5;
+    w.addObject(floor);
+
+    std::shared_ptr<Sphere> glass = Sphere::createGlassSphere();
+    glass->setTransform(Matrix4::translation(1.5, 0, -1) * Matrix4::scaling(0.5, 0.5, 0.5));
+    glass->getMaterial().reflective = 0.9;
+    w.addObject(glass);
+
+    std::shared_ptr<Cube> cube = Cube::createCube();
+    cube->setTransform(Matrix4::translation(-2, 0, 1) * Matrix4::scaling(0.5, 0.5, 0.5));
+    w.addObject(cube);
+    return w;
+}
+
+TEST_CASE("Tracing rays doesn't allocate", "[allocation]") {
+    World w = makeAllocationTestWorld();
+    w.buildAccelerationStructure();
+
+    std::vector<Ray> rays;
+    for (int i = 0; i < 16; i++) {
+        rays.push_back(Ray(Tuple::point(0, 0.5, -5), Tuple::normalize(Tuple::vector((i % 4) * 0.2 - 0.3, (i / 4) * 0.1 - 0.25, 1))));
+    }
+
+    // The first pass grows the per-thread buffers to their working size.
+    for (const Ray &r : rays) {
+        w.colorAt(r);
+    }
+
+    SECTION("Allocations of over-aligned types are counted too") {
+        struct alignas(2 * __STDCPP_DEFAULT_NEW_ALIGNMENT__) OverAligned {
+            char bytes[2 * __STDCPP_DEFAULT_NEW_ALIGNMENT__];
+        };
+        long before = allocationCount;
+        std::vector<OverAligned> queue;
+        queue.reserve(4);
+        REQUIRE(allocationCount - before == 1);
+        REQUIRE(reinterpret_cast<uintptr_t>(queue.data()) % alignof(OverAligned) == 0);
+    }
+
+    SECTION("colorAt() makes no allocations once the buffers are warm") {
+        long before = allocationCount;
+        for (const Ray &r : rays) {
+            w.colorAt(r);
+        }
+        REQUIRE(allocationCount - before == 0);
+    }
+
+    SECTION("isShadowed() makes no allocations once the buffers are warm") {
+        long before = allocationCount;
+        REQUIRE(w.isShadowed(Tuple::point(-10, 10, -10), Tuple::point(2, -0.9, 2)));
+        REQUIRE(!w.isShadowed(Tuple::point(-10, 10, -10), Tuple::point(-5, 5, -5)));
+        REQUIRE(allocationCount - before == 0);
+    }
+
+    SECTION("prepareHit() makes no allocations once the buffers are warm") {
+        std::vector<Intersection> xs;
+        xs.reserve(16);
+        w.intersectsToHit(rays[5], xs);
+        std::optional<Intersection> hit = Intersection::hit(xs);
+        REQUIRE(hit.has_value());
+
+        long before = allocationCount;
+        Hit h = hit.value().prepareHit(rays[5], xs);
+        REQUIRE(allocationCount - before == 0);
+        REQUIRE(h.getObject() == hit->getObject());
+    }
+}
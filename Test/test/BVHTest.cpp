@@ -0,0 +1,142 @@
+#include <catch.hpp>
+#include <Bounds.h>
+#include <BVH.h>
+#include <algorithm>
+#include <stdexcept>
+
+TEST_CASE("Bounds working as expected", "[bounds]") {
+    SECTION("A default bounding box is empty") {
+        Bounds b = Bounds();
+        REQUIRE(b.isEmpty());
+        REQUIRE(b.surfaceArea() == 0.0);
+    }
+
+    SECTION("Extending a bounding box with points") {
+        Bounds b = Bounds();
+        b.extend(Tuple::point(-5, 2, 0));
+        b.extend(Tuple::point(7, 0, -3));
+        REQUIRE(b.min == Tuple::point(-5, 0, -3));
+        REQUIRE(b.max == Tuple::point(7, 2, 0));
+        REQUIRE(b.centroid() == Tuple::point(1, 1, -1.5));
+        REQUIRE(b.largestAxis() == 0);
+    }
+
+    SECTION("Transforming a bounding box") {
+        Bounds b = Bounds(Tuple::point(-1, -1, -1), Tuple::point(1, 1, 1));
+        Bounds t = Bounds::transform(b, Matrix4::translation(1, 2, 3) * Matrix4::scaling(2, 1, 1));
+        REQUIRE(t.min == Tuple::point(-1, 1, 2));
+        REQUIRE(t.max == Tuple::point(3, 3, 4));
+    }
+
+    SECTION("An infinite bounding box stays infinite under a transformation") {
+        Bounds t = Bounds::transform(Bounds::infinite(), Matrix4::translation(0, -1, 0));
+        REQUIRE(t.isInfinite());
+    }
+
+    SECTION("Intersecting a ray with a bounding box") {
+        Bounds b = Bounds(Tuple::point(-1, -1, -1), Tuple::point(1, 1, 1));
+        Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
+        double tEntry, tExit;
+        REQUIRE(b.intersects(r, Bounds::inverseDirection(r), -INFINITY, INFINITY, tEntry, tExit));
+        REQUIRE(tEntry == 4);
+        REQUIRE(tExit == 6);
+
+        Ray miss = Ray(Tuple::point(2, 0, -5), Tuple::vector(0, 0, 1));
+        REQUIRE(!b.intersects(miss, Bounds::inverseDirection(miss), -INFINITY, INFINITY, tEntry, tExit));
+    }
+
+    SECTION("A bounding box outside the ray interval is missed") {
+        Bounds b = Bounds(Tuple::point(-1, -1, -1), Tuple::point(1, 1, 1));
+        Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
+        double tEntry, tExit;
+        REQUIRE(!b.intersects(r, Bounds::inverseDirection(r), 0, 3, tEntry, tExit));
+        REQUIRE(!b.intersects(r, Bounds::inverseDirection(r), 7, INFINITY, tEntry, tExit));
+    }
+}
+
+TEST_CASE("BVH working as expected", "[bvh]") {
+    SECTION("A BVH over no primitives is empty") {
+        BVH bvh = BVH(std::vector<Bounds>{});
+        REQUIRE(bvh.isEmpty());
+    }
+
+    SECTION("A BVH contains every primitive exactly once") {
+        std::vector<Bounds> bounds;
+        for (int i = 0; i < 100; i++) {
+            bounds.push_back(Bounds(Tuple::point(i, 0, 0), Tuple::point(i + 0.5, 1, 1)));
+        }
+        BVH bvh = BVH(bounds);
+        std::vector<int> indices = bvh.getPrimitiveIndices();
+        std::sort(indices.begin(), indices.end());
+        for (int i = 0; i < 100; i++) {
+            REQUIRE(indices[i] == i);
+        }
+        REQUIRE(bvh.getBounds().min == Tuple::point(0, 0, 0));
+        REQUIRE(bvh.getBounds().max == Tuple::point(99.5, 1, 1));
+    }
+
+    SECTION("A BVH can be rebuilt from its nodes") {
+        std::vector<Bounds> bounds;
+        for (int i = 0; i < 20; i++) {
+            bounds.push_back(Bounds(Tuple::point(i, 0, 0), Tuple::point(i + 0.5, 1, 1)));
+        }
+        BVH bvh = BVH(bounds);
+        BVH copy = BVH(bvh.getNodes(), bvh.getPrimitiveIndices());
+        REQUIRE(copy.getBounds().min == bvh.getBounds().min);
+        REQUIRE(copy.getBounds().max == bvh.getBounds().max);
+
+        std::vector<BVHNode> nodes = bvh.getNodes();
+        nodes[0].offset = static_cast<int>(nodes.size());
+        REQUIRE_THROWS_AS(BVH(nodes, bvh.getPrimitiveIndices()), std::invalid_argument);
+    }
+
+    SECTION("Traversing a BVH visits the primitives along the ray front to back") {
+        std::vector<Bounds> bounds;
+        for (int i = 0; i < 64; i++) {
+            bounds.push_back(Bounds(Tuple::point(i, 0, 0), Tuple::point(i + 0.5, 1, 1)));
+        }
+        BVH bvh = BVH(bounds);
+        Ray r = Ray(Tuple::point(100, 0.5, 0.5), Tuple::vector(-1, 0, 0));
+        std::vector<int> visited;
+        double tMax = INFINITY;
+        bvh.traverse(r, 0.0, tMax, [&](int index, double & /*limit*/) {
+            visited.push_back(index);
+            return false;
+        });
+        REQUIRE(visited.size() == 64);
+        REQUIRE(visited.front() >= 64 - BVH::MAX_LEAF_SIZE);
+    }
+
+    SECTION("Shrinking the interval during traversal skips farther primitives") {
+        std::vector<Bounds> bounds;
+        for (int i = 0; i < 64; i++) {
+            bounds.push_back(Bounds(Tuple::point(i, 0, 0), Tuple::point(i + 0.5, 1, 1)));
+        }
+        BVH bvh = BVH(bounds);
+        Ray r = Ray(Tuple::point(-1, 0.5, 0.5), Tuple::vector(1, 0, 0));
+        int visitedCount = 0;
+        double tMax = INFINITY;
+        bvh.traverse(r, 0.0, tMax, [&](int /*index*/, double &limit) {
+            visitedCount++;
+            limit = std::min(limit, 1.5);
+            return false;
+        });
+        REQUIRE(visitedCount < 64);
+    }
+
+    SECTION("Returning true from the callback ends the traversal") {
+        std::vector<Bounds> bounds;
+        for (int i = 0; i < 64; i++) {
+            bounds.push_back(Bounds(Tuple::point(i, 0, 0), Tuple::point(i + 0.5, 1, 1)));
+        }
+        BVH bvh = BVH(bounds);
+        Ray r = Ray(Tuple::point(-1, 0.5, 0.5), Tuple::vector(1, 0, 0));
+        int visitedCount = 0;
+        double tMax = INFINITY;
+        bvh.traverse(r, 0.0, tMax, [&](int /*index*/, double & /*limit*/) {
+            visitedCount++;
+            return true;
+        });
+        REQUIRE(visitedCount == 1);
+    }
+}
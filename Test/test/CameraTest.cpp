@@ -2,6 +2,9 @@
 #include <Camera.h>
 #include <World.h>
 #include <Canvas.h>
+#include <Shapes/Sphere.h>
+#include <Shapes/Plane.h>
+#include <Shapes/Cube.h>
 
 static const double PI = 3.14159265;
 static const double EPSILON = 0.00001;
@@ -15,7 +18,7 @@ TEST_CASE("Camera working properly", "[camera]") {
         REQUIRE(camera.hSize == hsize);
         REQUIRE(camera.vSize == vsize);
         REQUIRE(camera.fieldOfView == fieldOfView);
-        REQUIRE(camera.getTransform() == Matrix::identity4x4);
+        REQUIRE(camera.getTransform() == Matrix4::identity());
     }
 
     SECTION("The pixel size for a horizontal canvas") {
@@ -44,7 +47,7 @@ TEST_CASE("Camera working properly", "[camera]") {
 
     SECTION("Constructing a ray when the camera is transformed") {
         Camera camera = Camera::makeCamera(201, 101, PI / 2);
-        camera.setTransform(Matrix::rotationY(PI / 4) * Matrix::translation(0, -2, 5));
+        camera.setTransform(Matrix4::rotationY(PI / 4) * Matrix4::translation(0, -2, 5));
         Ray r = camera.rayForPixel(100, 50);
         REQUIRE(r.origin == Tuple::point(0, 2, -5));
         REQUIRE(r.direction == Tuple::vector(sqrt(2)/2, 0, -sqrt(2)/2));
@@ -56,8 +59,250 @@ TEST_CASE("Camera working properly", "[camera]") {
         Tuple from = Tuple::point(0, 0, -5);
         Tuple to = Tuple::point(0, 0, 0);
         Tuple up = Tuple::vector(0, 1, 0);
-        camera.setTransform(Matrix::viewTransform(from, to, up));
+        camera.setTransform(Matrix4::viewTransform(from, to, up));
         Canvas image = camera.render(w);
         REQUIRE(image.at(5, 5) == Color::Color(0.38066, 0.47583, 0.2855));
     }
-}
\ No newline at end of file
+
+    SECTION("Rendering with several threads matches a single-threaded render") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(23, 17, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings single;
+        single.threadCount = 1;
+        RenderSettings multi;
+        multi.threadCount = 4;
+        multi.tileSize = 5;
+
+        Canvas expected = camera.render(w, single);
+        Canvas actual = camera.render(w, multi);
+        for (int y = 0; y < camera.vSize; y++) {
+            for (int x = 0; x < camera.hSize; x++) {
+                REQUIRE(actual.at(x, y) == expected.at(x, y));
+            }
+        }
+    }
+
+    SECTION("Rendering with ray packets matches rendering ray by ray") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Plane> floor = Plane::createPlane();
+        floor->setTransform(Matrix4::translation(0, -1, 0));
+        w.addObject(floor);
+        std::shared_ptr<Cube> cube = Cube::createCube();
+        cube->setTransform(Matrix4::translation(2, 0, 1) * Matrix4::scaling(0.5, 0.5, 0.5));
+        w.addObject(cube);
+        std::shared_ptr<Sphere> glass = Sphere::createGlassSphere();
+        glass->setTransform(Matrix4::translation(-1.5, 0, -1) * Matrix4::scaling(0.5, 0.5, 0.5));
+        w.addObject(glass);
+        w.buildAccelerationStructure();
+
+        Camera camera = Camera::makeCamera(23, 17, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 1, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings single;
+        single.threadCount = 1;
+        single.packetSize = 1;
+        Canvas expected = camera.render(w, single);
+
+        for (int packetSize : { 4, 8, 16 }) {
+            RenderSettings packets;
+            packets.threadCount = 1;
+            packets.tileSize = 7;
+            packets.packetSize = packetSize;
+            Canvas actual = camera.render(w, packets);
+            for (int y = 0; y < camera.vSize; y++) {
+                for (int x = 0; x < camera.hSize; x++) {
+                    REQUIRE(actual.at(x, y) == expected.at(x, y));
+                }
+            }
+        }
+    }
+
+    SECTION("Unsupported packet sizes are rejected") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(11, 11, PI / 2);
+        RenderSettings settings;
+        settings.packetSize = 3;
+        REQUIRE_THROWS_AS(camera.render(w, settings), std::invalid_argument);
+    }
+
+    SECTION("A progressive render ends up with the same image as a direct one") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(23, 17, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings direct;
+        direct.threadCount = 1;
+        Canvas expected = camera.render(w, direct);
+
+        for (int packetSize : { 1, 8 }) {
+            RenderSettings progressive;
+            progressive.threadCount = 2;
+            progressive.tileSize = 10;
+            progressive.packetSize = packetSize;
+            progressive.progressive = true;
+            int previews = 0;
+            bool fullSize = true;
+            Canvas actual = camera.render(w, progressive, [&](const Canvas &preview) {
+                previews++;
+                fullSize = fullSize && preview.width == camera.hSize && preview.height == camera.vSize;
+            });
+
+            // Passes with blocks of 8, 4, 2 and 1 pixels, every pass but the last one gets a preview.
+            REQUIRE(previews == 3);
+            REQUIRE(fullSize);
+            for (int y = 0; y < camera.vSize; y++) {
+                for (int x = 0; x < camera.hSize; x++) {
+                    REQUIRE(actual.at(x, y) == expected.at(x, y));
+                }
+            }
+        }
+    }
+
+    SECTION("Rendering tile by tile produces the same pixels as a whole image") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(23, 17, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings settings;
+        settings.threadCount = 3;
+        settings.tileSize = 5;
+        Canvas expected = camera.render(w, settings);
+
+        Canvas actual = Canvas(camera.hSize, camera.vSize);
+        int tiles = 0;
+        camera.renderTiles(w, settings, [&](const Canvas &tile, int x0, int y0) {
+            tiles++;
+            REQUIRE(tile.width == std::min(5, camera.hSize - x0));
+            REQUIRE(tile.height == std::min(5, camera.vSize - y0));
+            for (int y = 0; y < tile.height; y++) {
+                for (int x = 0; x < tile.width; x++) {
+                    actual.set(x0 + x, y0 + y, tile.at(x, y));
+                }
+            }
+        });
+
+        REQUIRE(tiles == 5 * 4);
+        for (int y = 0; y < camera.vSize; y++) {
+            for (int x = 0; x < camera.hSize; x++) {
+                REQUIRE(actual.at(x, y) == expected.at(x, y));
+            }
+        }
+    }
+
+    SECTION("An error from a tile callback reaches the caller") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(23, 17, PI / 2);
+
+        RenderSettings settings;
+        settings.threadCount = 3;
+        settings.tileSize = 5;
+        int tiles = 0;
+        REQUIRE_THROWS_AS(camera.renderTiles(w, settings, [&](const Canvas & /*tile*/, int /*x*/, int y) {
+            tiles++;
+            if (y > 0) {
+                throw std::invalid_argument("tile rejected");
+            }
+        }), std::invalid_argument);
+        // The render stops at the first error, the other workers finish at most the tile they were on.
+        REQUIRE(tiles < 5 * 4);
+    }
+
+    SECTION("The first progressive pass fills whole blocks") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(16, 16, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings settings;
+        settings.threadCount = 1;
+        settings.progressive = true;
+        bool first = true;
+        camera.render(w, settings, [&](const Canvas &preview) {
+            if (first) {
+                first = false;
+                for (int y = 0; y < 16; y++) {
+                    for (int x = 0; x < 16; x++) {
+                        REQUIRE(preview.at(x, y) == preview.at(0, 0));
+                    }
+                }
+            }
+        });
+        REQUIRE(!first);
+    }
+
+    SECTION("Running out of time returns the image early") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(50, 50, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings settings;
+        settings.threadCount = 1;
+        settings.progressive = true;
+        settings.timeLimit = 0.000001;
+        int previews = 0;
+        Canvas image = camera.render(w, settings, [&](const Canvas & /*preview*/) { previews++; });
+        REQUIRE(previews == 0);
+        REQUIRE(image.width == 50);
+    }
+
+    SECTION("A ray through an offset point of a pixel") {
+        Camera c = Camera::makeCamera(201, 101, PI / 2);
+        Ray center = c.rayForPixel(100, 50);
+        Ray same = c.rayForPixel(100, 50, 0.5, 0.5);
+        REQUIRE((same.direction == center.direction));
+        Camera even = Camera::makeCamera(200, 100, PI / 2);
+        Ray corner = even.rayForPixel(0, 0, 0, 0);
+        REQUIRE((corner.direction == Tuple::normalize(Tuple::vector(1, 0.5, -1))));
+    }
+
+    SECTION("Anti-aliasing only refines pixels with contrasting samples") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(31, 21, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        for (int packetSize : { 1, 8 }) {
+            RenderSettings settings;
+            settings.threadCount = 1;
+            settings.packetSize = packetSize;
+            settings.maxSamples = 16;
+            settings.contrastThreshold = 0.05;
+            RenderStats::reset();
+            Canvas image = camera.render(w, settings);
+            RenderStats stats = RenderStats::collect();
+
+            const long long pixels = 31 * 21;
+            REQUIRE(stats.refinedPixels > 0);
+            REQUIRE(stats.refinedPixels < pixels);
+            REQUIRE(stats.primaryRays == pixels * Camera::INITIAL_SAMPLES + stats.extraSamples);
+            REQUIRE(stats.extraSamples <= stats.refinedPixels * (16 - Camera::INITIAL_SAMPLES));
+            // The background corner has nothing to anti-alias.
+            REQUIRE(image.at(0, 0) == Color(0, 0, 0));
+        }
+    }
+
+    SECTION("Anti-aliased edges blend the colors on both sides") {
+        World w = World::makeDefaultWorld();
+        Camera camera = Camera::makeCamera(31, 21, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+
+        RenderSettings aliased;
+        aliased.threadCount = 1;
+        RenderSettings smooth = aliased;
+        smooth.maxSamples = 64;
+        smooth.contrastThreshold = 0.0;
+        Canvas hard = camera.render(w, aliased);
+        Canvas soft = camera.render(w, smooth);
+
+        // Along a row through the sphere's silhouette the anti-aliased image has intermediate values the aliased one lacks.
+        int y = 10;
+        int blended = 0;
+        for (int x = 0; x < 31; x++) {
+            double brightness = soft.at(x, y).red;
+            if (brightness > 0.01 && brightness < hard.at(x, y).red - 0.01) {
+                blended++;
+            }
+        }
+        REQUIRE(blended > 0);
+    }
+}
@@ -4,9 +4,9 @@
 TEST_CASE("Color operations working correctly", "[color]") {
     SECTION("Colors are (red, green, blue) tuples") {
         Color c = Color::Color(-0.5, 0.4, 1.7);
-        REQUIRE(c.red == -0.5);
-        REQUIRE(c.green == 0.4);
-        REQUIRE(c.blue == 1.7);
+        REQUIRE(c.red == Real(-0.5));
+        REQUIRE(c.green == Real(0.4));
+        REQUIRE(c.blue == Real(1.7));
     }
 
     SECTION("Adding colors") {
@@ -0,0 +1,168 @@
+#include <catch.hpp>
+#include <ImageIOInterface.h>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+static std::string temporaryPath(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / name).string();
+}
+
+static std::vector<char> readFile(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static Canvas testCanvas()
+{
+    Canvas canvas = Canvas(3, 2);
+    canvas.set(0, 0, Color(1, 0, 0));
+    canvas.set(1, 0, Color(0, 1, 0));
+    canvas.set(2, 0, Color(0, 0, 1));
+    canvas.set(0, 1, Color(0.5, 0.25, 0.125));
+    canvas.set(1, 1, Color(4, 2, 1));
+    canvas.set(2, 1, Color(0, 0, 0));
+    return canvas;
+}
+
+TEST_CASE("Image input and output working as expected", "[imageio]") {
+    SECTION("The output format follows the extension") {
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.jpg"));
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.JPEG"));
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.png"));
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.hdr"));
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.pfm"));
+        REQUIRE(ImageIOInterface::isSupportedFormat("render.exr"));
+        REQUIRE(!ImageIOInterface::isSupportedFormat("render.gif"));
+        REQUIRE(!ImageIOInterface::isSupportedFormat("render"));
+        REQUIRE_THROWS_AS(ImageIOInterface::saveToImage(testCanvas(), temporaryPath("raymond_test.gif")), std::invalid_argument);
+    }
+
+    SECTION("PNG images are lossless within 8 bits") {
+        const std::string path = temporaryPath("raymond_test.png");
+        ImageIOInterface::saveToImage(testCanvas(), path);
+        Canvas loaded = ImageIOInterface::canvasFromImage(path);
+        std::remove(path.c_str());
+
+        REQUIRE(loaded.width == 3);
+        REQUIRE(loaded.height == 2);
+        REQUIRE(loaded.at(0, 0) == Color(1, 0, 0));
+        REQUIRE(loaded.at(2, 0) == Color(0, 0, 1));
+        REQUIRE(loaded.at(0, 1).red == Approx(128 / 255.0));
+        REQUIRE(loaded.at(1, 1) == Color(1, 1, 1));
+    }
+
+    SECTION("PFM images keep the float values") {
+        const std::string path = temporaryPath("raymond_test.pfm");
+        ImageIOInterface::saveToImage(testCanvas(), path);
+        std::vector<char> file = readFile(path);
+        std::remove(path.c_str());
+
+        const std::string header = "PF\n3 2\n-1.0\n";
+        REQUIRE(std::string(file.begin(), file.begin() + header.size()) == header);
+        REQUIRE(file.size() == header.size() + 3 * 2 * 3 * sizeof(float));
+        float values[18];
+        std::memcpy(values, file.data() + header.size(), sizeof(values));
+        // Rows go from the bottom up.
+        REQUIRE(values[0] == 0.5f);
+        REQUIRE(values[3] == 4.0f);
+        REQUIRE(values[9] == 1.0f);
+        REQUIRE(values[13] == 1.0f);
+    }
+
+    SECTION("EXR images have a valid header and one block per scanline") {
+        const std::string path = temporaryPath("raymond_test.exr");
+        ImageIOInterface::saveToImage(testCanvas(), path);
+        std::vector<char> file = readFile(path);
+        std::remove(path.c_str());
+
+        int32_t magic;
+        std::memcpy(&magic, file.data(), sizeof(magic));
+        REQUIRE(magic == 20000630);
+
+        // The header ends with an empty attribute name right before the offset table.
+        const std::string lastAttribute = "screenWindowWidth";
+        auto found = std::search(file.begin(), file.end(), lastAttribute.begin(), lastAttribute.end());
+        REQUIRE(found != file.end());
+        const size_t headerEnd = (found - file.begin()) + lastAttribute.size() + 1 + std::strlen("float") + 1 + 4 + 4 + 1;
+        uint64_t offsets[2];
+        std::memcpy(offsets, file.data() + headerEnd, sizeof(offsets));
+        REQUIRE(offsets[0] == headerEnd + sizeof(offsets));
+
+        int32_t y, size;
+        float blue[3], green[3], red[3];
+        std::memcpy(&y, file.data() + offsets[1], sizeof(y));
+        std::memcpy(&size, file.data() + offsets[1] + 4, sizeof(size));
+        std::memcpy(blue, file.data() + offsets[1] + 8, sizeof(blue));
+        std::memcpy(green, file.data() + offsets[1] + 20, sizeof(green));
+        std::memcpy(red, file.data() + offsets[1] + 32, sizeof(red));
+        REQUIRE(y == 1);
+        REQUIRE(size == 36);
+        REQUIRE(file.size() == offsets[1] + 8 + 36);
+        REQUIRE(red[1] == 4.0f);
+        REQUIRE(green[1] == 2.0f);
+        REQUIRE(blue[0] == 0.125f);
+    }
+
+    SECTION("Streamed tiles give the same file as saving the whole image") {
+        Canvas canvas = Canvas(37, 23);
+        for (int y = 0; y < canvas.height; y++) {
+            for (int x = 0; x < canvas.width; x++) {
+                canvas.set(x, y, Color(x / 36.0, y / 22.0, ((x * y) % 7) * 0.3));
+            }
+        }
+
+        for (const std::string extension : { ".png", ".pfm", ".exr" }) {
+            const std::string wholePath = temporaryPath("raymond_test_whole" + extension);
+            const std::string streamedPath = temporaryPath("raymond_test_streamed" + extension);
+            ImageIOInterface::saveToImage(canvas, wholePath);
+
+            // Tiles of 8 by 8 pixels, handed over from the bottom right so rows have to wait for the ones above.
+            std::unique_ptr<ImageIOInterface::TileWriter> writer = ImageIOInterface::openTileWriter(streamedPath, canvas.width, canvas.height);
+            for (int y0 = 16; y0 >= 0; y0 -= 8) {
+                for (int x0 = 32; x0 >= 0; x0 -= 8) {
+                    Canvas tile = Canvas(std::min(8, canvas.width - x0), std::min(8, canvas.height - y0));
+                    for (int y = 0; y < tile.height; y++) {
+                        for (int x = 0; x < tile.width; x++) {
+                            tile.set(x, y, canvas.at(x0 + x, y0 + y));
+                        }
+                    }
+                    writer->write(tile, x0, y0);
+                }
+            }
+            writer->finish();
+
+            if (extension == ".png") {
+                Canvas whole = ImageIOInterface::canvasFromImage(wholePath);
+                Canvas streamed = ImageIOInterface::canvasFromImage(streamedPath);
+                REQUIRE(streamed.width == canvas.width);
+                REQUIRE(streamed.height == canvas.height);
+                for (int y = 0; y < canvas.height; y++) {
+                    for (int x = 0; x < canvas.width; x++) {
+                        REQUIRE(streamed.at(x, y) == whole.at(x, y));
+                    }
+                }
+            }
+            else {
+                REQUIRE(readFile(streamedPath) == readFile(wholePath));
+            }
+            std::remove(wholePath.c_str());
+            std::remove(streamedPath.c_str());
+        }
+    }
+
+    SECTION("Only some formats can be streamed") {
+        REQUIRE(ImageIOInterface::isStreamableFormat("render.PNG"));
+        REQUIRE(ImageIOInterface::isStreamableFormat("render.pfm"));
+        REQUIRE(ImageIOInterface::isStreamableFormat("render.exr"));
+        REQUIRE(!ImageIOInterface::isStreamableFormat("render.jpg"));
+        REQUIRE(!ImageIOInterface::isStreamableFormat("render.hdr"));
+        REQUIRE_THROWS_AS(ImageIOInterface::openTileWriter(temporaryPath("raymond_test.jpg"), 4, 4), std::invalid_argument);
+    }
+}
@@ -13,7 +13,7 @@ TEST_CASE("Intersections working as expected", "[intersection]") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
         Intersection i = Intersection::Intersection(3.5, s);
         REQUIRE(i.getT() == 3.5);
-        REQUIRE(i.getObject() == s);
+        REQUIRE(i.getObject() == s.get());
     }
 
     SECTION("Aggregating intersections") {
@@ -105,7 +105,7 @@ TEST_CASE("Intersections working as expected", "[intersection]") {
     SECTION("The hit should offset the point") {
         Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::translation(0, 0, 1));
+        s->setTransform(Matrix4::translation(0, 0, 1));
         Intersection i = Intersection(5, s);
         Hit h = i.prepareHit(r, { i });
         REQUIRE(h.overPoint[2] < EPSILON/2);
@@ -122,13 +122,13 @@ TEST_CASE("Intersections working as expected", "[intersection]") {
 
     SECTION("Finding n1 and n2 at various intersections") {
         std::shared_ptr<Sphere> A = Sphere::createGlassSphere();
-        A->setTransform(Matrix::scaling(2, 2, 2));
+        A->setTransform(Matrix4::scaling(2, 2, 2));
         A->getMaterial().refractiveIndex = 1.5;
         std::shared_ptr<Sphere> B = Sphere::createGlassSphere();
-        B->setTransform(Matrix::translation(0, 0, -0.25));
+        B->setTransform(Matrix4::translation(0, 0, -0.25));
         B->getMaterial().refractiveIndex = 2.0;
         std::shared_ptr<Sphere> C = Sphere::createGlassSphere();
-        C->setTransform(Matrix::translation(0, 0, 0.25));
+        C->setTransform(Matrix4::translation(0, 0, 0.25));
         C->getMaterial().refractiveIndex = 2.5;
 
         Ray r = Ray(Tuple::point(0, 0, -4), Tuple::vector(0, 0, 1));
@@ -161,10 +161,52 @@ TEST_CASE("Intersections working as expected", "[intersection]") {
         REQUIRE(h5.n2 == 1.0);
     }
 
+    SECTION("Opaque hits skip resolving n1 and n2") {
+        std::shared_ptr<Sphere> glass = Sphere::createGlassSphere();
+        glass->setTransform(Matrix4::scaling(2, 2, 2));
+        std::shared_ptr<Sphere> opaque = Sphere::createSphere();
+        opaque->getMaterial().refractiveIndex = 1.8;
+
+        Ray r = Ray(Tuple::point(0, 0, -4), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> intersections = { Intersection(2, glass), Intersection(3, opaque) };
+        Hit h = intersections[1].prepareHit(r, intersections);
+        REQUIRE(h.n1 == 1.0);
+        REQUIRE(h.n2 == 1.0);
+    }
+
+    SECTION("Refractive indices are resolved through deeply nested shapes") {
+        // More nested spheres than fit in the container stack's fixed storage.
+        std::vector<std::shared_ptr<Sphere>> spheres;
+        std::vector<Intersection> intersections;
+        for (int i = 0; i < 20; i++) {
+            std::shared_ptr<Sphere> s = Sphere::createGlassSphere();
+            s->getMaterial().refractiveIndex = 1.05 + i * 0.1;
+            spheres.push_back(s);
+            intersections.push_back(Intersection(i, s));
+        }
+        for (int i = 19; i >= 0; i--) {
+            intersections.push_back(Intersection(40 - i, spheres[i]));
+        }
+
+        Ray r = Ray(Tuple::point(0, 0, -50), Tuple::vector(0, 0, 1));
+        Hit enter = intersections[19].prepareHit(r, intersections);
+        REQUIRE(enter.n1 == Approx(2.85));
+        REQUIRE(enter.n2 == Approx(2.95));
+        Hit leave = intersections[20].prepareHit(r, intersections);
+        REQUIRE(leave.n1 == Approx(2.95));
+        REQUIRE(leave.n2 == Approx(2.85));
+        Hit outer = intersections[36].prepareHit(r, intersections);
+        REQUIRE(outer.n1 == Approx(1.35));
+        REQUIRE(outer.n2 == Approx(1.25));
+        Hit outermost = intersections[39].prepareHit(r, intersections);
+        REQUIRE(outermost.n1 == Approx(1.05));
+        REQUIRE(outermost.n2 == 1.0);
+    }
+
     SECTION("The under point is offset below the surface") {
         Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
         std::shared_ptr<Sphere> glassSphere = Sphere::createGlassSphere();
-        glassSphere->setTransform(Matrix::translation(0, 0, 1));
+        glassSphere->setTransform(Matrix4::translation(0, 0, 1));
         Intersection i = Intersection::Intersection(5, glassSphere);
         Hit h = i.prepareHit(r, { i });
         REQUIRE(h.underPoint[2] > EPSILON / 2);
@@ -40,4 +40,51 @@ TEST_CASE("Area lights working as expected", "[arealight]") {
         REQUIRE(light.sample(2, 0) == Tuple::point(1.25, 0, 0.25));
         REQUIRE(light.sample(3, 1) == Tuple::point(1.75, 0, 0.75));
     }
+}
+
+TEST_CASE("Area light sample positions", "[arealight]") {
+    Tuple corner = Tuple::point(0, 0, 0);
+    Color intensity = Color::Color(1, 1, 1);
+    Tuple v1 = Tuple::vector(2, 0, 0);
+    Tuple v2 = Tuple::vector(0, 0, 1);
+
+    SECTION("Without jitter the sample positions are the cell centers") {
+        AreaLight light = AreaLight(intensity, corner, v1, 4, v2, 2, false);
+        REQUIRE(light.samplePosition(0, Tuple::point(0, 5, 0)) == light.sample(0, 0));
+        REQUIRE(light.samplePosition(1, Tuple::point(0, 5, 0)) == light.sample(0, 1));
+        REQUIRE(light.samplePosition(7, Tuple::point(0, 5, 0)) == light.sample(3, 1));
+    }
+
+    SECTION("Jittered sample positions lie on the light and repeat for the same point") {
+        AreaLight light = AreaLight(intensity, corner, v1, 4, v2, 2, true);
+        Tuple point = Tuple::point(0.3, 5, -1);
+        for (int i = 0; i < light.samples; i++) {
+            Tuple position = light.samplePosition(i, point);
+            REQUIRE(position == light.samplePosition(i, point));
+            REQUIRE(position[0] >= 0);
+            REQUIRE(position[0] < 2);
+            REQUIRE(position[1] == 0);
+            REQUIRE(position[2] >= 0);
+            REQUIRE(position[2] < 1);
+        }
+        REQUIRE(!(light.samplePosition(0, point) == light.samplePosition(0, Tuple::point(0.4, 5, -1))));
+    }
+
+    SECTION("Probes span the light from corner to corner and its center") {
+        AreaLight light = AreaLight(intensity, corner, v1, 4, v2, 2, false);
+        REQUIRE(light.probeCount() == 0);
+        light.probeSteps = 1;
+        REQUIRE(light.probeCount() == 0);
+        light.probeSteps = 2;
+        REQUIRE(light.probeCount() == 5);
+        REQUIRE(light.probePosition(0) == light.center);
+        REQUIRE(light.probePosition(1) == Tuple::point(0, 0, 0));
+        REQUIRE(light.probePosition(2) == Tuple::point(0, 0, 1));
+        REQUIRE(light.probePosition(3) == Tuple::point(2, 0, 0));
+        REQUIRE(light.probePosition(4) == Tuple::point(2, 0, 1));
+        light.probeSteps = 3;
+        REQUIRE(light.probeCount() == 9);
+        REQUIRE(light.probePosition(0) == Tuple::point(0, 0, 0));
+        REQUIRE(light.probePosition(4) == light.center);
+    }
 }
\ No newline at end of file
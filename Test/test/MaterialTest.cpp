@@ -20,15 +20,25 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple eyev = Tuple::vector(0, 0, -1);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 0, -10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 1.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(1.9, 1.9, 1.9)));
     }
 
+    SECTION("Ambient and direct lighting add up to the full lighting") {
+        Tuple eyev = Tuple::vector(0, 0, -1);
+        Tuple normalv = Tuple::vector(0, 0, -1);
+        PointLight light = PointLight::PointLight(Tuple::point(0, 0, -10), Color::Color(1, 1, 1));
+        Color ambient = m.ambientLighting(Matrix4::identity(), light.intensity, position);
+        Color direct = m.directLighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
+        REQUIRE((ambient == Color::Color(0.1, 0.1, 0.1)));
+        REQUIRE((direct == Color::Color(1.8, 1.8, 1.8)));
+    }
+
     SECTION("Lighting with the eye between the light and the surface, eye offset 45") {
         Tuple eyev = Tuple::vector(0, sqrt(2.0) / 2.0, -sqrt(2.0) / 2.0);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 0, -10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 1.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(1.0, 1.0, 1.0)));
     }
 
@@ -36,7 +46,7 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple eyev = Tuple::vector(0, 0, -1);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 10, -10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 1.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(0.7364, 0.7364, 0.7364)));
     }
 
@@ -44,7 +54,7 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple eyev = Tuple::vector(0, -sqrt(2.0) / 2.0, -sqrt(2.0) / 2.0);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 10, -10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 1.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(1.6364, 1.6364, 1.6364)));
     }
 
@@ -52,7 +62,7 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple eyev = Tuple::vector(0, 0, -1);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 0, 10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 1.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(0.1, 0.1, 0.1)));
     }
 
@@ -60,7 +70,7 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple eyev = Tuple::vector(0, 0, -1);
         Tuple normalv = Tuple::vector(0, 0, -1);
         PointLight light = PointLight::PointLight(Tuple::point(0, 0, -10), Color::Color(1, 1, 1));
-        Color result = m.lighting(Matrix::getIdentity4x4(), light, position, eyev, normalv, 0.0);
+        Color result = m.lighting(Matrix4::identity(), light, position, eyev, normalv, 0.0);
         REQUIRE((result == Color::Color(0.1, 0.1, 0.1)));
     }
 
@@ -75,11 +85,11 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple pt = Tuple::point(0, 0, -1);
         Tuple eyev = Tuple::vector(0, 0, -1);
         Tuple normalv = Tuple::vector(0, 0, -1);
-        Color result = w.getObject(0)->getMaterial().lighting(Matrix::getIdentity4x4(), w.getPointLight(0), pt, eyev, normalv, 1.0);
+        Color result = w.getObject(0)->getMaterial().lighting(Matrix4::identity(), w.getPointLight(0), pt, eyev, normalv, 1.0);
         REQUIRE((result == Color::Color(1, 1, 1)));
-        result = w.getObject(0)->getMaterial().lighting(Matrix::getIdentity4x4(), w.getPointLight(0), pt, eyev, normalv, 0.5);
+        result = w.getObject(0)->getMaterial().lighting(Matrix4::identity(), w.getPointLight(0), pt, eyev, normalv, 0.5);
         REQUIRE((result == Color::Color(0.55, 0.55, 0.55)));
-        result = w.getObject(0)->getMaterial().lighting(Matrix::getIdentity4x4(), w.getPointLight(0), pt, eyev, normalv, 0.0);
+        result = w.getObject(0)->getMaterial().lighting(Matrix4::identity(), w.getPointLight(0), pt, eyev, normalv, 0.0);
         REQUIRE((result == Color::Color(0.1, 0.1, 0.1)));
     }
 
@@ -98,13 +108,13 @@ TEST_CASE("Lighting working properly", "[material]") {
         Tuple pt = Tuple::point(0, 0, -1);
         Tuple eyev = Tuple::normalize(eye - pt);
         Tuple normalv = Tuple::vector(pt[0], pt[1], pt[2]);
-        Color result = s1->getMaterial().lighting(Matrix::getIdentity4x4(), light, pt, eyev, normalv, 1.0);
+        Color result = s1->getMaterial().lighting(Matrix4::identity(), light, pt, eyev, normalv, 1.0);
         REQUIRE(result == Color(0.9965, 0.9965, 0.9965));
 
         pt = Tuple::point(0, 0.7071, -0.7071);
         eyev = Tuple::normalize(eye - pt);
         normalv = Tuple::vector(pt[0], pt[1], pt[2]);
-        result = s1->getMaterial().lighting(Matrix::getIdentity4x4(), light, pt, eyev, normalv, 1.0);
+        result = s1->getMaterial().lighting(Matrix4::identity(), light, pt, eyev, normalv, 1.0);
         REQUIRE(result == Color(0.6232, 0.6232, 0.6232));
     }
 
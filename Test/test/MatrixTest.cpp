@@ -1,5 +1,6 @@
 #include <catch.hpp>
 #include <Matrix.h>
+#include <Matrix4.h>
 #include <Tuple.h>
 
 #include <iostream>
@@ -454,4 +455,81 @@ TEST_CASE("Matrix transformations working properly", "[matrixtransformations]")
         Matrix m = Matrix::Matrix(4, values);
         REQUIRE(t == m);
     }
-}
\ No newline at end of file
+}
+
+static Matrix toMatrix(const Matrix4 &m) {
+    Matrix result = Matrix(4);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            result(i, j) = m(i, j);
+        }
+    }
+    return result;
+}
+
+TEST_CASE("Fixed-size 4x4 matrices working properly", "[matrix4]") {
+    SECTION("Matrix4 transformations can be built at compile time") {
+        constexpr Matrix4 transform = Matrix4::translation(1, 2, 3) * Matrix4::scaling(2, 2, 2);
+        static_assert(transform(0, 0) == 2.0, "scaling is applied");
+        static_assert(transform(2, 3) == 3.0, "translation is applied");
+        constexpr Matrix4 inverse = Matrix4::inverse(transform);
+        static_assert(inverse(0, 3) == -0.5, "the inverse undoes the translation");
+        REQUIRE((transform * inverse == Matrix4::identity()));
+    }
+
+    SECTION("Multiplying Matrix4s matches the reference matrix") {
+        Matrix4 a = Matrix4({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 8, 7, 6, 5, 4, 3, 2 });
+        Matrix4 b = Matrix4({ -2, 1, 2, 3, 3, 2, 1, -1, 4, 3, 6, 5, 1, 2, 7, 8 });
+        REQUIRE((toMatrix(a * b) == toMatrix(a) * toMatrix(b)));
+        REQUIRE((a * Tuple(1, 2, 3, 1) == toMatrix(a) * Tuple(1, 2, 3, 1)));
+    }
+
+    SECTION("Transposing a Matrix4") {
+        Matrix4 a = Matrix4({ 0, 9, 3, 0, 9, 8, 0, 8, 1, 8, 5, 3, 0, 0, 5, 8 });
+        REQUIRE((toMatrix(Matrix4::transpose(a)) == Matrix::transpose(toMatrix(a))));
+        Tuple t = Tuple(1, -2, 3, 0.5);
+        REQUIRE((Matrix4::multiplyTransposed(a, t) == Matrix4::transpose(a) * t));
+    }
+
+    SECTION("The normal matrix transforms vectors like the transposed inverse and keeps w at 0") {
+        Matrix4 inverse = Matrix4::inverse(Matrix4::translation(1, 2, 3) * Matrix4::rotationZ(0.5) * Matrix4::scaling(1, 2, 3));
+        Matrix4 normalMatrix = Matrix4::normalMatrix(inverse);
+        Tuple n = Tuple::vector(0.3, -0.4, 0.5);
+        Tuple expected = Matrix4::transpose(inverse) * n;
+        expected[3] = 0;
+        REQUIRE((normalMatrix * n == expected));
+        REQUIRE((normalMatrix * Tuple::point(1, 1, 1))[3] == 0);
+    }
+
+    SECTION("The determinant of a Matrix4 matches the cofactor expansion") {
+        Matrix4 a = Matrix4({ -2, -8, 3, 5, -3, 1, 7, 3, 1, 2, -9, 6, -6, 7, 7, -9 });
+        REQUIRE(Matrix4::determinant(a) == Approx(-4071));
+        REQUIRE(Matrix4::isInvertible(a));
+        Matrix4 singular = Matrix4({ -4, 2, -2, -3, 9, 6, 2, 6, 0, -5, 1, -5, 0, 0, 0, 0 });
+        REQUIRE(!Matrix4::isInvertible(singular));
+    }
+
+    SECTION("The closed-form inverse of a general Matrix4 matches the reference inverse") {
+        Matrix4 a = Matrix4({ -5, 2, 6, -8, 1, -5, 1, 8, 7, 7, -6, -7, 1, -3, 7, 4 });
+        REQUIRE(!Matrix4::isAffine(a));
+        REQUIRE((toMatrix(Matrix4::inverse(a)) == Matrix::inverse(toMatrix(a))));
+    }
+
+    SECTION("The affine inverse of a Matrix4 matches the reference inverse") {
+        Matrix4 a = Matrix4::translation(1, -2, 3) * Matrix4::rotationY(0.7) * Matrix4::shearing(1, 0, 0.5, 0, 0, 1) * Matrix4::scaling(2, 0.5, 3);
+        REQUIRE(Matrix4::isAffine(a));
+        REQUIRE((toMatrix(Matrix4::inverse(a)) == Matrix::inverse(toMatrix(a))));
+        REQUIRE((a * Matrix4::inverse(a) == Matrix4::identity()));
+    }
+
+    SECTION("Inverting a noninvertible Matrix4 throws") {
+        REQUIRE_THROWS_AS(Matrix4::inverse(Matrix4::scaling(1, 0, 1)), std::invalid_argument);
+    }
+
+    SECTION("The Matrix4 view transformation matches the reference matrix") {
+        Tuple from = Tuple::point(1, 3, 2);
+        Tuple to = Tuple::point(4, -2, 8);
+        Tuple up = Tuple::vector(1, 1, 0);
+        REQUIRE((toMatrix(Matrix4::viewTransform(from, to, up)) == Matrix::viewTransform(from, to, up)));
+    }
+}
@@ -117,7 +117,7 @@ TEST_CASE("Patterns working as expected", "[pattern]") {
 TEST_CASE("Texture", "[texture]") {
     SECTION("Pattern with an object transformation") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::scaling(2, 2, 2));
+        s->setTransform(Matrix4::scaling(2, 2, 2));
 
         std::shared_ptr<Stripe> pattern = Stripe::createStripe(Color::white, Color::black);
         std::shared_ptr<SphericalMap> map = SphericalMap::createSphericalMap();
@@ -134,19 +134,19 @@ TEST_CASE("Texture", "[texture]") {
         std::shared_ptr<SphericalMap> map = SphericalMap::createSphericalMap();
 
         Texture texture = Texture(pattern, map);
-        texture.setTransform(Matrix::scaling(2, 2, 2));
+        texture.setTransform(Matrix4::scaling(2, 2, 2));
         Color c = texture.atObject(s->getInverseTransform(), Tuple::point(1.5, 0, 0));
         REQUIRE(c == Color::white);
     }
 
     SECTION("Pattern with both an object and a pattern transformation") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::scaling(2, 2, 2));
+        s->setTransform(Matrix4::scaling(2, 2, 2));
         std::shared_ptr<Stripe> pattern = Stripe::createStripe(Color::white, Color::black);
         std::shared_ptr<SphericalMap> map = SphericalMap::createSphericalMap();
 
         Texture texture = Texture(pattern, map);
-        texture.setTransform(Matrix::scaling(2, 2, 2));
+        texture.setTransform(Matrix4::scaling(2, 2, 2));
         Color c = texture.atObject(s->getInverseTransform(), Tuple::point(2.5, 0, 0));
         REQUIRE(c == Color::white);
     }
@@ -155,6 +155,111 @@ TEST_CASE("Texture", "[texture]") {
         std::shared_ptr<Checkers> checkers = Checkers::createCheckers(16, 8, Color::black, Color::white);
         std::shared_ptr<SphericalMap> map = SphericalMap::createSphericalMap();
         Texture texture = Texture(checkers, map);
-        REQUIRE(texture.atObject(Matrix::getIdentity4x4(), Tuple::point(0.4315, 0.4670, 0.7719)) == Color::white);
+        REQUIRE(texture.atObject(Matrix4::identity(), Tuple::point(0.4315, 0.4670, 0.7719)) == Color::white);
 ;    }
 }
+
+static Canvas checkerCanvas(int width, int height, const Color &dark, const Color &light)
+{
+    Canvas canvas = Canvas(width, height);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            canvas.set(x, y, (x + y) % 2 == 0 ? dark : light);
+        }
+    }
+    return canvas;
+}
+
+TEST_CASE("Image textures", "[texture]") {
+    // Black and white average to 0.5, which 8 bits round to 128.
+    const Color gray = Color(128 / 255.0, 128 / 255.0, 128 / 255.0);
+
+    SECTION("8-bit images are stored in 8 bits, others in half floats") {
+        UVImage ldr = UVImage(checkerCanvas(4, 4, Color(0, 0, 0), Color(1, 128 / 255.0, 1)));
+        REQUIRE(ldr.getFormat() == UVImage::Format::UNORM8);
+        REQUIRE(ldr.texel(0, 1, 0) == Color(1, 128 / 255.0, 1));
+
+        UVImage hdr = UVImage(checkerCanvas(4, 4, Color(0, 0, 0), Color(4, 0.1, 1)));
+        REQUIRE(hdr.getFormat() == UVImage::Format::HALF);
+        REQUIRE(hdr.texel(0, 1, 0).red == 4.0);
+        REQUIRE(hdr.texel(0, 1, 0).green == Approx(0.1).epsilon(0.001));
+    }
+
+    SECTION("Every mip level halves the previous one down to a single texel") {
+        UVImage image = UVImage(checkerCanvas(20, 6, Color::black, Color::white));
+        REQUIRE(image.getLevelCount() == 5);
+        const int widths[5] = { 20, 10, 5, 2, 1 };
+        const int heights[5] = { 6, 3, 1, 1, 1 };
+        for (int level = 0; level < 5; level++) {
+            REQUIRE(image.getLevelWidth(level) == widths[level]);
+            REQUIRE(image.getLevelHeight(level) == heights[level]);
+        }
+        // Levels are stored in whole tiles: 3 x 1 tiles for the full image, 2 x 1 for the next one, then one tile each.
+        const int tile = UVImage::TILE_SIZE * UVImage::TILE_SIZE;
+        REQUIRE(image.getTexels().size() == 3 * (3 * tile + 2 * tile + 3 * tile));
+        // A checkerboard averages to gray from the first level down.
+        REQUIRE(image.texel(1, 3, 2) == gray);
+        REQUIRE(image.texel(4, 0, 0) == gray);
+    }
+
+    SECTION("Odd sized levels filter every texel into the next one") {
+        Canvas canvas = Canvas(3, 1);
+        canvas.set(2, 0, Color::white);
+        UVImage image = UVImage(canvas);
+        REQUIRE(image.getLevelCount() == 2);
+        REQUIRE(image.texel(1, 0, 0) == Color(85 / 255.0, 85 / 255.0, 85 / 255.0));
+
+        // 5 x 3 down to 2 x 1 and 1 x 1. The second texel covers half of column 2 and columns 3 and 4, the last one
+        // keeps the average of the whole image.
+        Canvas column = Canvas(5, 3);
+        for (int y = 0; y < 3; y++) {
+            column.set(4, y, Color::white);
+        }
+        UVImage columnImage = UVImage(column);
+        REQUIRE(columnImage.getLevelCount() == 3);
+        const Color left = columnImage.texel(1, 0, 0);
+        const Color right = columnImage.texel(1, 1, 0);
+        REQUIRE(left == Color::black);
+        REQUIRE(right == Color(102 / 255.0, 102 / 255.0, 102 / 255.0));
+        REQUIRE(columnImage.texel(2, 0, 0) == Color(51 / 255.0, 51 / 255.0, 51 / 255.0));
+    }
+
+    SECTION("Lookups interpolate between texel centers") {
+        Canvas canvas = Canvas(2, 1);
+        canvas.set(0, 0, Color::black);
+        canvas.set(1, 0, Color::white);
+        UVImage image = UVImage(canvas);
+        REQUIRE(image.atUV(UV{ 0.25, 0.5 }) == Color::black);
+        REQUIRE(image.atUV(UV{ 0.5, 0.5 }) == Color(0.5, 0.5, 0.5));
+        REQUIRE(image.atUV(UV{ 0.75, 0.5 }) == Color::white);
+        // Past the outer texel centers the edge is clamped.
+        REQUIRE(image.atUV(UV{ 0, 0.5 }) == Color::black);
+        REQUIRE(image.atUV(UV{ 1, 0.5 }) == Color::white);
+    }
+
+    SECTION("Wider footprints read coarser levels") {
+        UVImage image = UVImage(checkerCanvas(16, 16, Color::black, Color::white));
+        const UV uv = UV{ 1.5 / 16, 1.5 / 16 };
+        REQUIRE(image.atUV(uv, 0) == image.atUV(uv));
+        REQUIRE(image.atUV(uv, 1.0 / 16) == image.texel(0, 1, 14));
+        REQUIRE(image.atUV(uv, 2.0 / 16) == gray);
+        REQUIRE(image.atUV(uv, 1) == gray);
+    }
+
+    SECTION("Texels can be stored and restored") {
+        UVImage image = UVImage(checkerCanvas(9, 5, Color(0.25, 0.5, 2), Color::white));
+        std::shared_ptr<UVImage> copy = UVImage::createUVImage(9, 5, image.getFormat(), image.getTexels());
+        REQUIRE(copy->texel(0, 8, 4) == image.texel(0, 8, 4));
+        REQUIRE(copy->texel(2, 1, 0) == image.texel(2, 1, 0));
+        REQUIRE_THROWS_AS(UVImage::createUVImage(17, 5, image.getFormat(), image.getTexels()), std::invalid_argument);
+    }
+
+    SECTION("A texture filters images over the footprint of the lookup") {
+        std::shared_ptr<UVImage> image = UVImage::createUVImage(std::make_shared<Canvas>(checkerCanvas(64, 64, Color::black, Color::white)));
+        Texture texture = Texture(image, PlanarMap::createPlanarMap());
+        const Tuple point = Tuple::point(0.25 + 0.5 / 64, 0, 0.25 + 0.5 / 64);
+        REQUIRE(texture.atObject(Matrix4::identity(), point) == image->atUV(UV{ point[0], point[2] }));
+        // A footprint of a quarter of the texture averages the checkerboard away.
+        REQUIRE(texture.atObject(Matrix4::identity(), point, 0.25) == gray);
+    }
+}
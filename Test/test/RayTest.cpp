@@ -66,13 +66,13 @@ TEST_CASE("Rays working as expected", "[ray]") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
         std::vector<Intersection> intersections = s->intersects(r);
         REQUIRE(intersections.size() == 2);
-        REQUIRE(intersections[0].getObject() == s);
-        REQUIRE(intersections[1].getObject() == s);
+        REQUIRE(intersections[0].getObject() == s.get());
+        REQUIRE(intersections[1].getObject() == s.get());
     }
 
     SECTION("Translating a ray") {
         Ray r = Ray::Ray(Tuple::point(1, 2, 3), Tuple::vector(0, 1, 0));
-        Matrix m = Matrix::translation(3, 4, 5);
+        Matrix4 m = Matrix4::translation(3, 4, 5);
         Ray r2 = Ray::transform(r, m);
         REQUIRE(r2.origin == Tuple::point(4, 6, 8));
         REQUIRE(r2.direction == Tuple::vector(0, 1, 0));
@@ -80,7 +80,7 @@ TEST_CASE("Rays working as expected", "[ray]") {
 
     SECTION("Scaling a ray") {
         Ray r = Ray::Ray(Tuple::point(1, 2, 3), Tuple::vector(0, 1, 0));
-        Matrix m = Matrix::scaling(2, 3, 4);
+        Matrix4 m = Matrix4::scaling(2, 3, 4);
         Ray r2 = Ray::transform(r, m);
         REQUIRE(r2.origin == Tuple::point(2, 6, 12));
         REQUIRE(r2.direction == Tuple::vector(0, 3, 0));
@@ -89,7 +89,7 @@ TEST_CASE("Rays working as expected", "[ray]") {
     SECTION("Intersecting a scaled sphere with a ray") {
         Ray r = Ray::Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::scaling(2, 2, 2));
+        s->setTransform(Matrix4::scaling(2, 2, 2));
         std::vector<Intersection> xs = s->intersects(r);
         REQUIRE(xs.size() == 2);
         REQUIRE(xs[0].getT() == 3);
@@ -99,7 +99,7 @@ TEST_CASE("Rays working as expected", "[ray]") {
     SECTION("Intersecting a translated sphere with a ray") {
         Ray r = Ray::Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::translation(5, 0, 0));
+        s->setTransform(Matrix4::translation(5, 0, 0));
         std::vector<Intersection> xs = s->intersects(r);
         REQUIRE(xs.size() == 0);
     }
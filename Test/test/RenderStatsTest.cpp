@@ -0,0 +1,82 @@
+#include <catch.hpp>
+#include <RenderStats.h>
+#include <Camera.h>
+#include <World.h>
+#include <thread>
+
+static const double PI = 3.14159265;
+
+TEST_CASE("Render statistics working as expected", "[stats]") {
+    SECTION("Merging adds every counter") {
+        RenderStats a, b;
+        a.primaryRays = 3;
+        a.bvhNodeVisits = 10;
+        b.primaryRays = 4;
+        b.shadowRays = 2;
+        b.lightingSeconds = 0.5;
+        a.merge(b);
+        REQUIRE(a.primaryRays == 7);
+        REQUIRE(a.shadowRays == 2);
+        REQUIRE(a.bvhNodeVisits == 10);
+        REQUIRE(a.lightingSeconds == 0.5);
+    }
+
+    SECTION("Counters of finished threads are merged into the totals") {
+        RenderStats::reset();
+        RenderStats::local().sphereTests += 1;
+        std::thread worker([]() {
+            RenderStats::local().sphereTests += 5;
+        });
+        worker.join();
+        REQUIRE(RenderStats::collect().sphereTests == 6);
+
+        RenderStats::reset();
+        REQUIRE(RenderStats::collect().sphereTests == 0);
+    }
+
+    SECTION("Rendering counts rays and tests") {
+        World w = World::makeDefaultWorld();
+        w.buildAccelerationStructure();
+        Camera camera = Camera::makeCamera(11, 11, PI / 2);
+        camera.setTransform(Matrix4::viewTransform(Tuple::point(0, 0, -5), Tuple::point(0, 0, 0), Tuple::vector(0, 1, 0)));
+        RenderSettings settings;
+        settings.threadCount = 2;
+        settings.packetSize = 1;
+
+        RenderStats::reset();
+        camera.render(w, settings);
+        RenderStats stats = RenderStats::collect();
+        REQUIRE(stats.primaryRays == 121);
+        REQUIRE(stats.prepareHitCalls > 0);
+        // One shadow ray per hit for the single point light.
+        REQUIRE(stats.shadowRays == stats.prepareHitCalls);
+        REQUIRE(stats.sphereTests > 0);
+        REQUIRE(stats.bvhNodeVisits > 0);
+        REQUIRE(stats.reflectionRays == 0);
+        REQUIRE(stats.refractionRays == 0);
+    }
+
+    SECTION("Stage timings are only taken while timing is enabled") {
+        RenderStats::reset();
+        {
+            StageTimer timer(&RenderStats::lightingSeconds);
+        }
+        REQUIRE(RenderStats::collect().lightingSeconds == 0);
+
+        RenderStats::setTimingEnabled(true);
+        {
+            StageTimer timer(&RenderStats::lightingSeconds);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        RenderStats::setTimingEnabled(false);
+        REQUIRE(RenderStats::collect().lightingSeconds > 0);
+    }
+
+    SECTION("Statistics can be written as JSON") {
+        RenderStats stats;
+        stats.shadowRays = 42;
+        std::string json = stats.toJSON();
+        REQUIRE(json.find("\"shadow\": 42") != std::string::npos);
+        REQUIRE(json.find("\"bvhNodeVisits\"") != std::string::npos);
+    }
+}
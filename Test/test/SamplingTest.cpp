@@ -0,0 +1,75 @@
+#include <catch.hpp>
+#include <Sampling.h>
+#include <set>
+#include <stdexcept>
+
+TEST_CASE("Sampling working as expected", "[sampling]") {
+    SECTION("Generators with the same seed give the same numbers") {
+        Sampling::Pcg32 a = Sampling::Pcg32(42);
+        Sampling::Pcg32 b = Sampling::Pcg32(42);
+        Sampling::Pcg32 c = Sampling::Pcg32(43);
+        bool differs = false;
+        for (int i = 0; i < 100; i++) {
+            uint32_t value = a.next();
+            REQUIRE(value == b.next());
+            differs = differs || value != c.next();
+        }
+        REQUIRE(differs);
+    }
+
+    SECTION("Random doubles lie in the unit interval") {
+        Sampling::Pcg32 generator = Sampling::Pcg32(7);
+        for (int i = 0; i < 1000; i++) {
+            double value = generator.nextDouble();
+            REQUIRE(value >= 0.0);
+            REQUIRE(value < 1.0);
+        }
+    }
+
+    SECTION("The radical inverse mirrors the digits of the index") {
+        REQUIRE(Sampling::radicalInverse(2, 1) == 0.5);
+        REQUIRE(Sampling::radicalInverse(2, 2) == 0.25);
+        REQUIRE(Sampling::radicalInverse(2, 3) == 0.75);
+        REQUIRE(Sampling::radicalInverse(3, 1) == Approx(1.0 / 3));
+        REQUIRE(Sampling::radicalInverse(3, 5) == Approx(7.0 / 9));
+    }
+
+    SECTION("The first Sobol points") {
+        const double expected[4][2] = { { 0, 0 }, { 0.5, 0.5 }, { 0.25, 0.75 }, { 0.75, 0.25 } };
+        for (int i = 0; i < 4; i++) {
+            REQUIRE(Sampling::sobol(0, i) == expected[i][0]);
+            REQUIRE(Sampling::sobol(1, i) == expected[i][1]);
+        }
+        REQUIRE_THROWS_AS(Sampling::sobol(2, 0), std::invalid_argument);
+    }
+
+    SECTION("Every power of two Sobol points put one point into each cell of a square grid") {
+        std::set<std::pair<int, int>> cells;
+        for (int i = 0; i < 64; i++) {
+            cells.insert({ int(Sampling::sobol(0, i) * 8), int(Sampling::sobol(1, i) * 8) });
+        }
+        REQUIRE(cells.size() == 64);
+    }
+
+    SECTION("Scrambled Sobol points keep the stratification") {
+        for (uint32_t seed : { 1u, 12345u, 4000000000u }) {
+            std::set<std::pair<int, int>> cells;
+            for (int i = 0; i < 16; i++) {
+                double u = Sampling::scrambledSobol(0, i, seed);
+                double v = Sampling::scrambledSobol(1, i, seed);
+                REQUIRE(u >= 0.0);
+                REQUIRE(u < 1.0);
+                cells.insert({ int(u * 4), int(v * 4) });
+            }
+            REQUIRE(cells.size() == 16);
+        }
+        REQUIRE(Sampling::scrambledSobol(0, 3, 1) != Sampling::scrambledSobol(0, 3, 2));
+    }
+
+    SECTION("Hashing a point depends on every coordinate") {
+        uint64_t h = Sampling::hash(Tuple::point(1, 2, 3));
+        REQUIRE(h == Sampling::hash(Tuple::point(1, 2, 3)));
+        REQUIRE(h != Sampling::hash(Tuple::point(1, 2, 3.0001)));
+        REQUIRE(h != Sampling::hash(Tuple::point(2, 1, 3)));
+    }
+}
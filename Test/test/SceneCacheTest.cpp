@@ -0,0 +1,184 @@
+#include <catch.hpp>
+#include <SceneCache.h>
+#include <ImageIOInterface.h>
+#include <OBJParser.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+static const std::string OBJ =
+    "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\nv -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+    "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+    "f 1/1 2/2 3/3 4/4\nf 5/1 6/2 7/3 8/4\nf 1/1 2/2 6/3 5/4\nf 4/1 3/2 7/3 8/4\nf 1/1 4/2 8/3 5/4\nf 2/1 3/2 7/3 6/4\n";
+
+// Named randomly, so test runs at the same time don't clear each other's files.
+static std::filesystem::path temporaryDirectory()
+{
+    std::random_device random;
+    const std::string name = "raymond_test_cache_" + std::to_string(random()) + "_" + std::to_string(random());
+    return std::filesystem::temp_directory_path() / name;
+}
+
+static void writeFile(const std::filesystem::path &path, const std::string &contents)
+{
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+}
+
+static int countEntries(const std::filesystem::path &directory)
+{
+    return static_cast<int>(std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator()));
+}
+
+static void requireSameMesh(const TriangleMesh &actual, const TriangleMesh &expected)
+{
+    REQUIRE(actual.getData().positions == expected.getData().positions);
+    REQUIRE(actual.getData().uvs == expected.getData().uvs);
+    REQUIRE(actual.getData().positionIndices == expected.getData().positionIndices);
+    REQUIRE(actual.getData().normalIndices == expected.getData().normalIndices);
+    REQUIRE(actual.getData().uvIndices == expected.getData().uvIndices);
+    REQUIRE(actual.getBVH().getPrimitiveIndices() == expected.getBVH().getPrimitiveIndices());
+    REQUIRE(actual.getBVH().getNodes().size() == expected.getBVH().getNodes().size());
+
+    const Ray r = Ray(Tuple::point(0.3, 0.2, -5), Tuple::vector(0, 0, 1));
+    std::vector<Intersection> actualHits, expectedHits;
+    actual.intersects(r, actualHits);
+    expected.intersects(r, expectedHits);
+    REQUIRE(actualHits.size() == expectedHits.size());
+    for (size_t i = 0; i < actualHits.size(); i++) {
+        REQUIRE(actualHits[i].getT() == expectedHits[i].getT());
+        REQUIRE(actualHits[i].getPrimitive() == expectedHits[i].getPrimitive());
+    }
+}
+
+TEST_CASE("Scene cache working as expected", "[cache]") {
+    const std::filesystem::path directory = temporaryDirectory();
+    const std::filesystem::path cacheDirectory = directory / "cache";
+    std::filesystem::create_directories(directory);
+    const std::string objPath = (directory / "box.obj").string();
+    writeFile(objPath, OBJ);
+
+    SECTION("A mesh read back from the cache matches the parsed one") {
+        std::shared_ptr<TriangleMesh> parsed = OBJParser::meshFromFile(objPath);
+        std::shared_ptr<TriangleMesh> written = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        REQUIRE(countEntries(cacheDirectory) == 1);
+
+        // The source is gone, so the second load has to come from the cache entry of the same contents.
+        const std::string copyPath = (directory / "copy.obj").string();
+        writeFile(copyPath, OBJ);
+        std::filesystem::remove(objPath);
+        std::shared_ptr<TriangleMesh> cached = SceneCache::loadMesh(copyPath, cacheDirectory.string());
+        REQUIRE(countEntries(cacheDirectory) == 1);
+
+        requireSameMesh(*written, *parsed);
+        requireSameMesh(*cached, *parsed);
+    }
+
+    SECTION("Changing the source adds a new entry") {
+        SceneCache::loadMesh(objPath, cacheDirectory.string());
+        writeFile(objPath, OBJ + "f 1 2 7\n");
+        std::shared_ptr<TriangleMesh> changed = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        REQUIRE(countEntries(cacheDirectory) == 2);
+        REQUIRE(changed->getTriangleCount() == 13);
+    }
+
+    SECTION("Loads missing the cache at the same time each write their own entry") {
+        std::vector<std::shared_ptr<TriangleMesh>> meshes(4);
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < meshes.size(); i++) {
+            threads.emplace_back([&, i]() {
+                meshes[i] = SceneCache::loadMesh(objPath, cacheDirectory.string());
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+
+        REQUIRE(countEntries(cacheDirectory) == 1);
+        requireSameMesh(*SceneCache::loadMesh(objPath, cacheDirectory.string()), *OBJParser::meshFromFile(objPath));
+    }
+
+    SECTION("A damaged entry is rebuilt") {
+        SceneCache::loadMesh(objPath, cacheDirectory.string());
+        const std::filesystem::path entry = std::filesystem::directory_iterator(cacheDirectory)->path();
+        const uintmax_t size = std::filesystem::file_size(entry);
+        std::filesystem::resize_file(entry, size / 2);
+
+        std::shared_ptr<TriangleMesh> rebuilt = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        requireSameMesh(*rebuilt, *OBJParser::meshFromFile(objPath));
+        REQUIRE(std::filesystem::file_size(entry) == size);
+    }
+
+    SECTION("An entry with a BVH deeper than the traversal stack is rebuilt") {
+        std::shared_ptr<TriangleMesh> written = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        const std::filesystem::path entry = std::filesystem::directory_iterator(cacheDirectory)->path();
+        const uintmax_t size = std::filesystem::file_size(entry);
+
+        // The nodes and primitive indices close the entry, each array after its 64 bit length.
+        const std::vector<int> &primitiveIndices = written->getBVH().getPrimitiveIndices();
+        const uintmax_t tail = sizeof(uint64_t) + written->getBVH().getNodes().size() * sizeof(BVHNode)
+            + sizeof(uint64_t) + primitiveIndices.size() * sizeof(int);
+        std::filesystem::resize_file(entry, size - tail);
+
+        // A chain of interior nodes, each with a leaf first and the rest of the chain second.
+        std::vector<BVHNode> chain;
+        const Bounds bounds = written->getBVH().getBounds();
+        for (int i = 0; i < BVH::MAX_DEPTH + 1; i++) {
+            chain.push_back(BVHNode{ bounds, static_cast<int>(chain.size()) + 2, 0, 0 });
+            chain.push_back(BVHNode{ bounds, 0, 1, 0 });
+        }
+        chain.push_back(BVHNode{ bounds, 0, static_cast<int>(primitiveIndices.size()), 0 });
+        {
+            std::ofstream file(entry, std::ios::binary | std::ios::app);
+            const uint64_t nodeCount = chain.size();
+            const uint64_t indexCount = primitiveIndices.size();
+            file.write(reinterpret_cast<const char*>(&nodeCount), sizeof(nodeCount));
+            file.write(reinterpret_cast<const char*>(chain.data()), chain.size() * sizeof(BVHNode));
+            file.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
+            file.write(reinterpret_cast<const char*>(primitiveIndices.data()), primitiveIndices.size() * sizeof(int));
+        }
+        REQUIRE_THROWS_AS(BVH(chain, primitiveIndices), std::invalid_argument);
+
+        std::shared_ptr<TriangleMesh> rebuilt = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        requireSameMesh(*rebuilt, *OBJParser::meshFromFile(objPath));
+        REQUIRE(std::filesystem::file_size(entry) == size);
+    }
+
+    SECTION("A texture read back from the cache matches the decoded one") {
+        Canvas canvas = Canvas(5, 3);
+        for (int y = 0; y < canvas.height; y++) {
+            for (int x = 0; x < canvas.width; x++) {
+                canvas.set(x, y, Color(x / 4.0, y / 2.0, 0.5));
+            }
+        }
+        const std::string imagePath = (directory / "texture.png").string();
+        ImageIOInterface::saveToImage(canvas, imagePath);
+
+        UVImage decoded = UVImage(ImageIOInterface::canvasFromImage(imagePath));
+        SceneCache::loadTexture(imagePath, cacheDirectory.string());
+        std::shared_ptr<UVImage> cached = SceneCache::loadTexture(imagePath, cacheDirectory.string());
+        REQUIRE(countEntries(cacheDirectory) == 1);
+        REQUIRE(cached->getWidth() == decoded.getWidth());
+        REQUIRE(cached->getHeight() == decoded.getHeight());
+        REQUIRE(cached->getFormat() == decoded.getFormat());
+        REQUIRE(cached->getTexels() == decoded.getTexels());
+    }
+
+    SECTION("A cache directory that can't be written doesn't stop the load") {
+        // A file where the directory should be.
+        writeFile(cacheDirectory, "");
+        std::shared_ptr<TriangleMesh> mesh = SceneCache::loadMesh(objPath, cacheDirectory.string());
+        requireSameMesh(*mesh, *OBJParser::meshFromFile(objPath));
+        REQUIRE(std::filesystem::is_regular_file(cacheDirectory));
+        REQUIRE(countEntries(directory) == 2);
+    }
+
+    SECTION("Missing sources are reported") {
+        REQUIRE_THROWS_AS(SceneCache::loadMesh((directory / "missing.obj").string(), cacheDirectory.string()), std::invalid_argument);
+    }
+
+    std::filesystem::remove_all(directory);
+}
@@ -2,18 +2,21 @@
 #include <Shapes/Sphere.h>
 #include <Shapes/Plane.h>
 #include <Shapes/Cube.h>
+#include <Shapes/Instance.h>
+#include <Shapes/TriangleMesh.h>
+#include <World.h>
 
 static const double PI = 3.14159265;
 
 TEST_CASE("Shapes working as expected", "[shape]") {
     SECTION("The default transformation") {
         std::shared_ptr<Shape> s = Sphere::createSphere();
-        REQUIRE((s->getTransform() == Matrix::identity4x4));
+        REQUIRE((s->getTransform() == Matrix4::identity()));
     }
 
     SECTION("Assigning a transformation") {
         std::shared_ptr<Shape> s = Sphere::createSphere();
-        Matrix t = Matrix::translation(2, 3, 4);
+        Matrix4 t = Matrix4::translation(2, 3, 4);
         s->setTransform(t);
         REQUIRE((s->getTransform() == t));
     }
@@ -33,13 +36,13 @@ TEST_CASE("Shapes working as expected", "[shape]") {
 
     SECTION("Computing the normal on a translated Shape") {
         std::shared_ptr<Shape> s = Sphere::createSphere();
-        s->setTransform(Matrix::translation(0, 1, 0));
+        s->setTransform(Matrix4::translation(0, 1, 0));
         Tuple n = s->normalAt(Tuple::point(0.0f, 1.70711, -0.70711));
         REQUIRE((n == Tuple::vector(0.0f, 0.70711, -0.70711)));
     }
     SECTION("Computing the normal on a transformed Shape") {
         std::shared_ptr<Shape> s = Sphere::createSphere();
-        s->setTransform(Matrix::scaling(1, 0.5, 1) * Matrix::rotationZ(PI / 5));
+        s->setTransform(Matrix4::scaling(1, 0.5, 1) * Matrix4::rotationZ(PI / 5));
         Tuple n = s->normalAt(Tuple::point(0.0, sqrt(2.0) / 2.0, -sqrt(2.0) / 2.0));
         REQUIRE((n == Tuple::vector(0.0, 0.97014f, -0.24254)));
     }
@@ -78,20 +81,20 @@ TEST_CASE("Spheres working as expected", "[sphere]") {
 
     SECTION("Computing the normal on a translated sphere") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::translation(0, 1, 0));
+        s->setTransform(Matrix4::translation(0, 1, 0));
         Tuple n = s->normalAt(Tuple::point(0.0f, 1.70711, -0.70711));
         REQUIRE((n == Tuple::vector(0.0f, 0.70711, -0.70711)));
     }
     SECTION("Computing the normal on a transformed sphere") {
         std::shared_ptr<Sphere> s = Sphere::createSphere();
-        s->setTransform(Matrix::scaling(1, 0.5, 1) * Matrix::rotationZ(PI / 5));
+        s->setTransform(Matrix4::scaling(1, 0.5, 1) * Matrix4::rotationZ(PI / 5));
         Tuple n = s->normalAt(Tuple::point(0.0, sqrt(2.0) / 2.0, -sqrt(2.0) / 2.0));
         REQUIRE((n == Tuple::vector(0.0, 0.97014f, -0.24254)));
     }
 
     SECTION("A helper for producing a sphere with a glassy material") {
         std::shared_ptr<Sphere> s = Sphere::createGlassSphere();
-        REQUIRE(s->getTransform() == Matrix::identity4x4);
+        REQUIRE(s->getTransform() == Matrix4::identity());
         REQUIRE(s->getMaterial().transparency == 1.0);
         REQUIRE(s->getMaterial().refractiveIndex == 1.5);
     }
@@ -105,6 +108,12 @@ TEST_CASE("Planes working as expected", "[plane]") {
         REQUIRE(s->normalAt(Tuple::point(-5, 0, 150)) == Tuple::vector(0, 1, 0));
     }
 
+    SECTION("The normal of a transformed plane follows its transform") {
+        std::shared_ptr<Plane> s = Plane::createPlane();
+        s->setTransform(Matrix4::translation(0, 3, 0) * Matrix4::rotationX(PI / 2));
+        REQUIRE(s->normalAt(Tuple::point(4, 3, 0)) == Tuple::vector(0, 0, 1));
+    }
+
     SECTION("Intersect with a ray parallel to the plane") {
         std::shared_ptr<Plane> p = Plane::createPlane();
         Ray r = Ray(Tuple::point(0, 10, 0), Tuple::vector(0, 0, 1));
@@ -125,7 +134,7 @@ TEST_CASE("Planes working as expected", "[plane]") {
         std::vector<Intersection> xs = p->intersects(r);
         REQUIRE(xs.size() == 1);
         REQUIRE(xs[0].getT() == 1);
-        REQUIRE(xs[0].getObject() == p);
+        REQUIRE(xs[0].getObject() == p.get());
     }
 
     SECTION("A ray intersecting a plane from below") {
@@ -134,7 +143,7 @@ TEST_CASE("Planes working as expected", "[plane]") {
         std::vector<Intersection> xs = p->intersects(r);
         REQUIRE(xs.size() == 1);
         REQUIRE(xs[0].getT() == 1);
-        REQUIRE(xs[0].getObject() == p);
+        REQUIRE(xs[0].getObject() == p.get());
     }
 }
 
@@ -215,4 +224,141 @@ TEST_CASE("Cube tests", "[cube]") {
         REQUIRE(c->normalAt(Tuple::point(1, 1, 1)) == Tuple::vector(1, 0, 0));
         REQUIRE(c->normalAt(Tuple::point(-1, -1, -1)) == Tuple::vector(-1, 0, 0));
     }
-}
\ No newline at end of file
+
+    SECTION("The normal on a transformed cube is in world space") {
+        std::shared_ptr<Cube> c = Cube::createCube();
+        c->setTransform(Matrix4::rotationZ(PI / 2) * Matrix4::scaling(1, 2, 1));
+        // The +y face of the object ends up facing -x after the rotation.
+        REQUIRE(c->normalAt(Tuple::point(-2, 0.3, 0.2)) == Tuple::vector(-1, 0, 0));
+        REQUIRE(c->normalAt(Tuple::point(0.5, 1, -0.2)) == Tuple::vector(0, 1, 0));
+    }
+}
+
+TEST_CASE("Instances working as expected", "[instance]") {
+    SECTION("An instance combines its placement with the prototype's transform") {
+        std::shared_ptr<Sphere> prototype = Sphere::createSphere();
+        prototype->setTransform(Matrix4::scaling(2, 2, 2));
+        std::shared_ptr<Instance> instance = Instance::createInstance(prototype);
+        instance->setTransform(Matrix4::translation(5, 0, 0));
+        REQUIRE((instance->getPlacement() == Matrix4::translation(5, 0, 0)));
+        REQUIRE((instance->getTransform() == Matrix4::translation(5, 0, 0) * Matrix4::scaling(2, 2, 2)));
+        REQUIRE((instance->getInverseTransform() == Matrix4::inverse(instance->getTransform())));
+    }
+
+    SECTION("Intersecting an instance reports hits on the instance") {
+        std::shared_ptr<Sphere> prototype = Sphere::createSphere();
+        std::shared_ptr<Instance> instance = Instance::createInstance(prototype);
+        instance->setTransform(Matrix4::translation(5, 0, 0));
+        Ray r = Ray(Tuple::point(5, 0, -5), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> xs = instance->intersects(r);
+        REQUIRE(xs.size() == 2);
+        REQUIRE(xs[0].getT() == 4);
+        REQUIRE(xs[1].getT() == 6);
+        REQUIRE(xs[0].getObject() == instance.get());
+        REQUIRE(prototype->intersects(r).empty());
+    }
+
+    SECTION("Computing the normal on an instance") {
+        std::shared_ptr<Sphere> prototype = Sphere::createSphere();
+        prototype->setTransform(Matrix4::scaling(1, 0.5, 1));
+        std::shared_ptr<Instance> instance = Instance::createInstance(prototype);
+        instance->setTransform(Matrix4::rotationZ(PI / 5));
+        std::shared_ptr<Sphere> equivalent = Sphere::createSphere();
+        equivalent->setTransform(Matrix4::rotationZ(PI / 5) * Matrix4::scaling(1, 0.5, 1));
+        Tuple point = Tuple::point(0, sqrt(2) / 2, -sqrt(2) / 2);
+        REQUIRE((instance->normalAt(point) == equivalent->normalAt(point)));
+    }
+
+    SECTION("Instances of a mesh share its geometry and keep the hit triangle") {
+        MeshData data;
+        data.positions = { 0, 1, 0, -1, 0, 0, 1, 0, 0 };
+        data.positionIndices = { 0, 1, 2 };
+        std::shared_ptr<TriangleMesh> mesh = TriangleMesh::createTriangleMesh(data);
+        std::shared_ptr<Instance> first = Instance::createInstance(mesh);
+        std::shared_ptr<Instance> second = Instance::createInstance(mesh);
+        second->setTransform(Matrix4::translation(0, 0, 3));
+        Ray r = Ray(Tuple::point(0, 0.5, -2), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> xs = second->intersects(r);
+        REQUIRE(xs.size() == 1);
+        REQUIRE(abs(xs[0].getT() - 5) < 0.00001);
+        REQUIRE(xs[0].getPrimitive() == 0);
+        Tuple n = second->normalAt(Ray::position(r, xs[0].getT()), xs[0]);
+        REQUIRE(abs(n[2]) == Approx(1));
+        REQUIRE(first->getPrototype() == second->getPrototype());
+        REQUIRE(second->occludes(r, 6));
+        REQUIRE(!second->occludes(r, 4));
+    }
+
+    SECTION("Instances share the material of their prototype") {
+        std::shared_ptr<Sphere> prototype = Sphere::createSphere();
+        std::shared_ptr<Instance> instance = Instance::createInstance(prototype);
+        instance->getMaterial().ambient = 0.5;
+        REQUIRE(prototype->getMaterial().ambient == 0.5);
+    }
+
+    SECTION("The world acceleration structure places instances by their combined bounds") {
+        std::shared_ptr<Cube> prototype = Cube::createCube();
+        prototype->setTransform(Matrix4::scaling(0.5, 0.5, 0.5));
+        World w = World();
+        for (int i = 0; i < 10; i++) {
+            std::shared_ptr<Instance> instance = Instance::createInstance(prototype);
+            instance->setTransform(Matrix4::translation(i * 2.0, 0, 0));
+            w.addObject(instance);
+        }
+        std::vector<Ray> rays;
+        for (int i = 0; i < 40; i++) {
+            rays.push_back(Ray(Tuple::point(i * 0.5 - 1, 0.1, -5), Tuple::vector(0, 0, 1)));
+        }
+        std::vector<std::vector<Intersection>> expected;
+        for (const Ray &r : rays) {
+            expected.push_back(w.intersects(r));
+        }
+        w.buildAccelerationStructure();
+        for (int i = 0; i < static_cast<int>(rays.size()); i++) {
+            REQUIRE(w.intersects(rays[i]) == expected[i]);
+        }
+        REQUIRE(w.intersects(rays[2]).size() == 2);
+    }
+}
+
+TEST_CASE("Ray packets working as expected", "[packet]") {
+    SECTION("Packet kernels find the same closest hits as single rays") {
+        std::shared_ptr<Sphere> sphere = Sphere::createSphere();
+        sphere->setTransform(Matrix4::translation(0.5, 0, 0) * Matrix4::scaling(1, 2, 1));
+        std::shared_ptr<Cube> cube = Cube::createCube();
+        cube->setTransform(Matrix4::rotationY(PI / 5));
+        std::shared_ptr<Plane> plane = Plane::createPlane();
+        plane->setTransform(Matrix4::rotationX(0.3));
+        std::shared_ptr<Shape> shapes[3] = { sphere, cube, plane };
+
+        RayPacket packet;
+        for (int i = 0; i < RayPacket::MAX_SIZE; i++) {
+            // Lanes starting inside the shapes and lanes missing them both take part.
+            Tuple origin = i % 3 == 0 ? Tuple::point(0.2, 0.1, 0) : Tuple::point(-2 + i * 0.3, 0.5, -5);
+            packet.add(Ray(origin, Tuple::normalize(Tuple::vector(0.1 * (i % 4) - 0.15, -0.05 * (i % 5), 1))));
+        }
+
+        for (const std::shared_ptr<Shape> &shape : shapes) {
+            PacketHits hits;
+            shape->intersects(packet, hits);
+            for (int lane = 0; lane < packet.size; lane++) {
+                std::vector<Intersection> xs = shape->intersects(packet.getRay(lane));
+                std::optional<Intersection> hit = Intersection::hit(xs);
+                REQUIRE(hit.has_value() == (hits.object[lane] != nullptr));
+                if (hit.has_value()) {
+                    REQUIRE(hits.t[lane] == hit->getT());
+                    REQUIRE(hits.object[lane] == shape.get());
+                }
+            }
+        }
+    }
+
+    SECTION("A packet holds at most MAX_SIZE rays") {
+        RayPacket packet;
+        Ray r = Ray(Tuple::point(0, 0, 0), Tuple::vector(0, 0, 1));
+        for (int i = 0; i < RayPacket::MAX_SIZE; i++) {
+            packet.add(r);
+        }
+        REQUIRE_THROWS_AS(packet.add(r), std::invalid_argument);
+    }
+}
@@ -0,0 +1,49 @@
+#include <catch.hpp>
+#include <ThreadPool.h>
+#include <atomic>
+
+TEST_CASE("Thread pool working as expected", "[threadpool]") {
+    SECTION("A thread pool has the requested number of workers") {
+        ThreadPool pool = ThreadPool(3);
+        REQUIRE(pool.getThreadCount() == 3);
+    }
+
+    SECTION("Requesting zero threads uses at least one worker") {
+        REQUIRE(ThreadPool::resolveThreadCount(0) >= 1);
+        REQUIRE(ThreadPool::resolveThreadCount(5) == 5);
+    }
+
+    SECTION("Waiting on a thread pool runs every submitted task") {
+        std::atomic<int> counter(0);
+        ThreadPool pool = ThreadPool(4);
+        for (int i = 0; i < 1000; i++) {
+            pool.submit([&counter]() { counter++; });
+        }
+        pool.wait();
+        REQUIRE(counter == 1000);
+    }
+
+    SECTION("A thread pool can be reused after waiting") {
+        std::atomic<int> counter(0);
+        ThreadPool pool = ThreadPool(2);
+        pool.submit([&counter]() { counter++; });
+        pool.wait();
+        pool.submit([&counter]() { counter += 2; });
+        pool.wait();
+        REQUIRE(counter == 3);
+    }
+
+    SECTION("Waiting on a thread pool covers tasks submitted by other tasks") {
+        std::atomic<int> counter(0);
+        ThreadPool pool = ThreadPool(4);
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&pool, &counter]() {
+                for (int j = 0; j < 10; j++) {
+                    pool.submit([&counter]() { counter++; });
+                }
+            });
+        }
+        pool.wait();
+        REQUIRE(counter == 1000);
+    }
+}
@@ -0,0 +1,261 @@
+#include <catch.hpp>
+#include <Shapes/TriangleMesh.h>
+#include <OBJParser.h>
+#include <RenderStats.h>
+#include <Texture/UVImage.h>
+#include <World.h>
+#include <algorithm>
+#include <sstream>
+
+static MeshData makeTriangle()
+{
+    MeshData data;
+    data.positions = { 0, 1, 0, -1, 0, 0, 1, 0, 0 };
+    data.positionIndices = { 0, 1, 2 };
+    return data;
+}
+
+TEST_CASE("Triangle meshes working as expected", "[mesh]") {
+    SECTION("Intersecting a ray parallel to the triangle") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        Ray r = Ray(Tuple::point(0, -1, -2), Tuple::vector(0, 1, 0));
+        REQUIRE(t->intersects(r).empty());
+    }
+
+    SECTION("A ray misses the triangle edges") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        REQUIRE(t->intersects(Ray(Tuple::point(1, 1, -2), Tuple::vector(0, 0, 1))).empty());
+        REQUIRE(t->intersects(Ray(Tuple::point(-1, 1, -2), Tuple::vector(0, 0, 1))).empty());
+        REQUIRE(t->intersects(Ray(Tuple::point(0, -1, -2), Tuple::vector(0, 0, 1))).empty());
+    }
+
+    SECTION("A ray strikes a triangle") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        Ray r = Ray(Tuple::point(0, 0.5, -2), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> xs = t->intersects(r);
+        REQUIRE(xs.size() == 1);
+        REQUIRE(abs(xs[0].getT() - 2) < 0.00001);
+        REQUIRE(xs[0].getPrimitive() == 0);
+    }
+
+    SECTION("Intersections carry the barycentric coordinates of the hit") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        Ray r = Ray(Tuple::point(-0.2, 0.3, -2), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> xs = t->intersects(r);
+        REQUIRE(xs.size() == 1);
+        REQUIRE(abs(xs[0].getU() - 0.45) < 0.00001);
+        REQUIRE(abs(xs[0].getV() - 0.25) < 0.00001);
+    }
+
+    SECTION("A ray through a shared edge hits exactly one of the triangles") {
+        MeshData data;
+        data.positions = { -1, -1, 0, 1, -1, 0, 1, 1, 0, -1, 1, 0 };
+        data.positionIndices = { 0, 1, 2, 0, 2, 3 };
+        std::shared_ptr<TriangleMesh> quad = TriangleMesh::createTriangleMesh(data);
+        for (int i = 0; i < 20; i++) {
+            double d = -0.9 + i * 0.09;
+            Ray r = Ray(Tuple::point(d, d, -5), Tuple::vector(0, 0, 1));
+            REQUIRE(!quad->intersects(r).empty());
+        }
+    }
+
+    SECTION("A triangle without vertex normals uses its face normal") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        Intersection i = Intersection(1, t.get(), 0, 0.3, 0.3);
+        Tuple n = t->normalAt(Tuple::point(0, 0.5, 0), i);
+        REQUIRE((n == Tuple::vector(0, 0, -1) || n == Tuple::vector(0, 0, 1)));
+    }
+
+    SECTION("Vertex normals are interpolated with the barycentric coordinates") {
+        MeshData data = makeTriangle();
+        data.normals = { 0, 1, 0, -1, 0, 0, 1, 0, 0 };
+        data.normalIndices = { 0, 1, 2 };
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(data);
+        Intersection i = Intersection(1, t.get(), 0, 0.45, 0.25);
+        REQUIRE((t->normalAt(Tuple::point(0, 0, 0), i) == Tuple::normalize(Tuple::vector(-0.2, 0.3, 0))));
+    }
+
+    SECTION("Preparing a hit on a mesh uses the hit triangle") {
+        MeshData data = makeTriangle();
+        data.normals = { 0, 1, 0, -1, 0, 0, 1, 0, 0 };
+        data.normalIndices = { 0, 1, 2 };
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(data);
+        Ray r = Ray(Tuple::point(-0.2, 0.3, -2), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> xs = t->intersects(r);
+        Hit hit = xs[0].prepareHit(r, xs);
+        REQUIRE((hit.normalv == Tuple::normalize(Tuple::vector(-0.2, 0.3, 0))));
+    }
+
+    SECTION("Texture coordinates are interpolated with the barycentric coordinates") {
+        MeshData data = makeTriangle();
+        data.uvs = { 0.5, 1, 0, 0, 1, 0 };
+        data.uvIndices = { 0, 1, 2 };
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(data);
+        UV uv = t->uvAt(Intersection(1, t.get(), 0, 0.45, 0.25));
+        REQUIRE(abs(uv.u - 0.4) < 0.00001);
+        REQUIRE(abs(uv.v - 0.3) < 0.00001);
+
+        // The triangle covers half the uv square with an area of 1, twice as large it has 4.
+        std::optional<SurfaceUV> surface = t->surfaceUVAt(Intersection(1, t.get(), 0, 0.45, 0.25));
+        REQUIRE(surface);
+        REQUIRE(surface->uv == uv);
+        REQUIRE(abs(surface->scale - sqrt(0.5)) < 0.00001);
+        t->setTransform(Matrix4::scaling(2, 2, 2));
+        REQUIRE(abs(t->surfaceUVAt(Intersection(1, t.get(), 0, 0.45, 0.25))->scale - sqrt(0.5) / 2) < 0.00001);
+        REQUIRE(!TriangleMesh::createTriangleMesh(makeTriangle())->surfaceUVAt(Intersection(1, t.get(), 0, 0.45, 0.25)));
+    }
+
+    SECTION("Textures on a mesh with texture coordinates look them up instead of their mapping") {
+        std::shared_ptr<Canvas> image = std::make_shared<Canvas>(2, 1);
+        image->set(0, 0, Color(1, 0, 0));
+        image->set(1, 0, Color(0, 0, 1));
+        Material material = Material(Color(1, 1, 1), 1, 0, 0, 0, 0, 0, 1);
+        material.texture = Texture::createTexture(UVImage::createUVImage(image), PlanarMap::createPlanarMap());
+
+        MeshData data = makeTriangle();
+        data.uvs = { 0.9, 0.5 };
+        data.uvIndices = { 0, 0, 0 };
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(data);
+        t->setMaterial(material);
+        World w = World();
+        w.addObject(t);
+        w.addLight(PointLight(Tuple::point(0, 0, -10), Color(1, 1, 1)));
+
+        // The planar mapping would put the hit at u = 0, on the red texel.
+        REQUIRE(w.colorAt(Ray(Tuple::point(0, 0.5, -2), Tuple::vector(0, 0, 1))) == Color(0, 0, 1));
+    }
+
+    SECTION("The bounds of a mesh enclose its triangles") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        Bounds b = t->getBounds();
+        REQUIRE((b.min == Tuple::point(-1, 0, 0)));
+        REQUIRE((b.max == Tuple::point(1, 1, 0)));
+    }
+
+    SECTION("Indices past the end of the arrays are rejected") {
+        MeshData data = makeTriangle();
+        data.positionIndices = { 0, 1, 3 };
+        REQUIRE_THROWS_AS(TriangleMesh::createTriangleMesh(data), std::invalid_argument);
+    }
+
+    SECTION("Copies of a mesh share the geometry but not the transform") {
+        std::shared_ptr<TriangleMesh> t = TriangleMesh::createTriangleMesh(makeTriangle());
+        std::shared_ptr<TriangleMesh> copy = std::make_shared<TriangleMesh>(*t);
+        copy->setTransform(Matrix4::translation(0, 0, 1));
+        REQUIRE(&copy->getData() == &t->getData());
+        Ray r = Ray(Tuple::point(0, 0.5, -2), Tuple::vector(0, 0, 1));
+        REQUIRE(abs(copy->intersects(r)[0].getT() - 3) < 0.00001);
+        REQUIRE(abs(t->intersects(r)[0].getT() - 2) < 0.00001);
+    }
+
+    SECTION("Looking for the hit skips triangles past the closest one") {
+        // 64 triangles stacked along z, one at every z from 0 to 63.
+        MeshData data;
+        for (int layer = 0; layer < 64; layer++) {
+            data.positions.insert(data.positions.end(), { 0, 1, double(layer), -1, 0, double(layer), 1, 0, double(layer) });
+            data.positionIndices.insert(data.positionIndices.end(), { 3 * layer, 3 * layer + 1, 3 * layer + 2 });
+        }
+        std::shared_ptr<TriangleMesh> stack = TriangleMesh::createTriangleMesh(data);
+        Ray r = Ray(Tuple::point(0, 0.5, 9.5), Tuple::vector(0, 0, 1));
+
+        RenderStats::reset();
+        std::vector<Intersection> all = stack->intersects(r);
+        const long long allTests = RenderStats::collect().triangleTests;
+        RenderStats::reset();
+        std::vector<Intersection> toHit;
+        stack->intersectsToHit(r, toHit);
+        REQUIRE(all.size() == 64);
+        REQUIRE(RenderStats::collect().triangleTests < allTests / 2);
+
+        // Everything behind the origin is still there, in front of it only the closest hit has to be.
+        REQUIRE(Intersection::hit(toHit) == Intersection::hit(all));
+        REQUIRE(abs(Intersection::hit(toHit)->getT() - 0.5) < 0.00001);
+        REQUIRE(std::count_if(toHit.begin(), toHit.end(), [](const Intersection &i) { return i.getT() < 0; }) == 10);
+    }
+
+    SECTION("A shadow ray stops at the first triangle of a mesh that blocks it") {
+        MeshData data;
+        for (int layer = 0; layer < 64; layer++) {
+            data.positions.insert(data.positions.end(), { 0, 1, double(layer), -1, 0, double(layer), 1, 0, double(layer) });
+            data.positionIndices.insert(data.positionIndices.end(), { 3 * layer, 3 * layer + 1, 3 * layer + 2 });
+        }
+        std::shared_ptr<TriangleMesh> stack = TriangleMesh::createTriangleMesh(data);
+        World w = World();
+        w.addObject(stack);
+        w.buildAccelerationStructure();
+        Ray r = Ray(Tuple::point(0, 0.5, 9.5), Tuple::vector(0, 0, 1));
+
+        RenderStats::reset();
+        stack->intersects(r);
+        const long long allTests = RenderStats::collect().triangleTests;
+        RenderStats::reset();
+        REQUIRE(w.occluded(r, 100));
+        REQUIRE(RenderStats::collect().triangleTests < allTests / 2);
+
+        REQUIRE(stack->occludes(r, 0.6));
+        REQUIRE(!stack->occludes(r, 0.4));
+        REQUIRE(!stack->occludes(Ray(Tuple::point(0, 0.5, -0.5), Tuple::vector(0, 0, -1)), 100));
+    }
+
+    SECTION("A closed mesh in a world agrees with and without an acceleration structure") {
+        std::istringstream obj(
+            "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\n"
+            "v -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n"
+            "f 1 2 3 4\nf 5 8 7 6\nf 1 5 6 2\nf 2 6 7 3\nf 3 7 8 4\nf 5 1 4 8\n");
+        std::shared_ptr<TriangleMesh> box = TriangleMesh::createTriangleMesh(OBJParser::parseOBJ(obj));
+        box->setTransform(Matrix4::translation(0, 0, 3));
+        World w = World();
+        w.addObject(box);
+        Ray r = Ray(Tuple::point(0.3, 0.2, -5), Tuple::vector(0, 0, 1));
+        std::vector<Intersection> linear = w.intersects(r);
+        w.buildAccelerationStructure();
+        std::vector<Intersection> accelerated = w.intersects(r);
+        REQUIRE(linear.size() == 2);
+        REQUIRE(linear == accelerated);
+        REQUIRE(abs(linear[0].getT() - 7) < 0.00001);
+        REQUIRE(abs(linear[1].getT() - 9) < 0.00001);
+    }
+}
+
+TEST_CASE("Parsing OBJ files", "[obj]") {
+    SECTION("Ignoring unrecognized lines") {
+        std::istringstream obj("There was a young lady named Bright\nwho traveled much faster than light.\n# comment\ng group\n");
+        MeshData data = OBJParser::parseOBJ(obj);
+        REQUIRE(data.positions.empty());
+        REQUIRE(data.getTriangleCount() == 0);
+    }
+
+    SECTION("Vertex records") {
+        std::istringstream obj("v -1 1 0\nv -1.0000 0.5000 0.0000\nv 1 0 0\nv 1 1 0\n");
+        MeshData data = OBJParser::parseOBJ(obj);
+        REQUIRE(data.positions == std::vector<double>{ -1, 1, 0, -1, 0.5, 0, 1, 0, 0, 1, 1, 0 });
+    }
+
+    SECTION("Polygons are split into triangle fans") {
+        std::istringstream obj("v -1 1 0\nv -1 0 0\nv 1 0 0\nv 1 1 0\nv 0 2 0\nf 1 2 3 4 5\n");
+        MeshData data = OBJParser::parseOBJ(obj);
+        REQUIRE(data.getTriangleCount() == 3);
+        REQUIRE(data.positionIndices == std::vector<int>{ 0, 1, 2, 0, 2, 3, 0, 3, 4 });
+        REQUIRE(data.normalIndices == std::vector<int>{ -1, -1, -1, -1, -1, -1, -1, -1, -1 });
+    }
+
+    SECTION("Faces with texture coordinates and normals") {
+        std::istringstream obj(
+            "v 0 1 0\nv -1 0 0\nv 1 0 0\n"
+            "vt 0.5 1\nvt 0 0\nvt 1 0\n"
+            "vn -1 0 0\nvn 1 0 0\nvn 0 1 0\n"
+            "f 1//3 2//1 3//2\nf 1/1/3 2/2/1 3/3/2\nf -3/1 -2/2 -1/3\n");
+        MeshData data = OBJParser::parseOBJ(obj);
+        REQUIRE(data.getTriangleCount() == 3);
+        REQUIRE(data.normals.size() == 9);
+        REQUIRE(data.uvs.size() == 6);
+        REQUIRE(data.normalIndices == std::vector<int>{ 2, 0, 1, 2, 0, 1, -1, -1, -1 });
+        REQUIRE(data.uvIndices == std::vector<int>{ -1, -1, -1, 0, 1, 2, 0, 1, 2 });
+        REQUIRE(data.positionIndices == std::vector<int>{ 0, 1, 2, 0, 1, 2, 0, 1, 2 });
+    }
+
+    SECTION("Faces referring to missing vertices are rejected") {
+        std::istringstream obj("v 0 1 0\nv -1 0 0\nf 1 2 3\n");
+        REQUIRE_THROWS_AS(OBJParser::parseOBJ(obj), std::invalid_argument);
+    }
+}
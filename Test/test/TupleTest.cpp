@@ -5,9 +5,9 @@
 TEST_CASE("Tuples are constructed correctly.", "[tuple]") {
     SECTION("A Tuple with w = 1.0 is a point") {
         Tuple t = Tuple(4.3, -4.2, 3.1, 1.0);
-        REQUIRE(t[0] == 4.3);
-        REQUIRE(t[1] == -4.2);
-        REQUIRE(t[2] == 3.1);
+        REQUIRE(t[0] == Real(4.3));
+        REQUIRE(t[1] == Real(-4.2));
+        REQUIRE(t[2] == Real(3.1));
         REQUIRE(t[3] == 1.0);
 
         REQUIRE(Tuple::isPoint(t));
@@ -16,9 +16,9 @@ TEST_CASE("Tuples are constructed correctly.", "[tuple]") {
 
     SECTION("A Tuple with w = 0.0 is a vector") {
         Tuple t = Tuple(4.3, -4.2, 3.1, 0.0);
-        REQUIRE(t[0] == 4.3);
-        REQUIRE(t[1] == -4.2);
-        REQUIRE(t[2] == 3.1);
+        REQUIRE(t[0] == Real(4.3));
+        REQUIRE(t[1] == Real(-4.2));
+        REQUIRE(t[2] == Real(3.1));
         REQUIRE(t[3] == 0.0);
         REQUIRE(Tuple::isVector(t));
         REQUIRE(!Tuple::isPoint(t));
@@ -165,4 +165,11 @@ TEST_CASE("Tuple operations are calculated properly.", "[tuple]") {
         Tuple r = Tuple::reflect(v, n);
         REQUIRE((r == Tuple::vector(1, 0, 0)));
     }
+
+    SECTION("Tuple arithmetic can be evaluated at compile time") {
+        constexpr Tuple c = Tuple::cross(Tuple::vector(1, 2, 3), Tuple::vector(2, 3, 4));
+        STATIC_REQUIRE(c == Tuple::vector(-1, 2, -1));
+        STATIC_REQUIRE(Tuple::dot(c, c) == 6);
+        STATIC_REQUIRE(Tuple::isVector(Tuple::point(1, 2, 3) - Tuple::point(3, 2, 1)));
+    }
 }
@@ -1,5 +1,6 @@
 #include <catch.hpp>
 #include <World.h>
+#include <RenderStats.h>
 #include <Shapes/Shape.h>
 #include <Shapes/Sphere.h>
 #include <Shapes/Plane.h>
@@ -18,7 +19,7 @@ TEST_CASE("World functionality", "[world]") {
         std::shared_ptr<Sphere> s1 = Sphere::createSphere();
         s1->setMaterial(Material(Color(0.8, 1.0, 0.6), 0.1, 0.7, 0.2, 200, 0, 0, 1));
         std::shared_ptr<Sphere> s2 = Sphere::createSphere();
-        s2->setTransform(Matrix::scaling(0.5, 0.5, 0.5));
+        s2->setTransform(Matrix4::scaling(0.5, 0.5, 0.5));
 
         REQUIRE(w.getObjectCount() == 2);
         REQUIRE((w.getObject(0)->getMaterial() == s1->getMaterial()));
@@ -50,6 +51,35 @@ TEST_CASE("World functionality", "[world]") {
         REQUIRE(c == Color(0.38066, 0.47583, 0.2855));
     }
 
+    SECTION("Sampling one of two equal lights gives the color of both") {
+        World w = World::makeDefaultWorld();
+        w.addLight(PointLight(Tuple::point(-10, 10, -10), Color(1, 1, 1)));
+        Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
+        Intersection i = Intersection(4, w.getObject(0));
+        Hit comps = i.prepareHit(r, { i });
+        Color expected = w.shadeHit(comps, 0);
+
+        w.setLightSamples(1);
+        RenderStats::reset();
+        REQUIRE(w.shadeHit(comps, 0) == expected);
+        REQUIRE(RenderStats::collect().shadowRays == 1);
+    }
+
+    SECTION("Sampling never picks a light behind the surface") {
+        World w = World::makeDefaultWorld();
+        w.addLight(PointLight(Tuple::point(0, 0, 10), Color(1, 1, 1)));
+        w.addLight(AreaLight(Color(1, 1, 1), Tuple::point(-1, -1, 10), Tuple::vector(2, 0, 0), 2, Tuple::vector(0, 2, 0), 2, false));
+        Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
+        Intersection i = Intersection(4, w.getObject(0));
+        Hit comps = i.prepareHit(r, { i });
+        Color expected = w.shadeHit(comps, 0);
+
+        w.setLightSamples(1);
+        RenderStats::reset();
+        REQUIRE(w.shadeHit(comps, 0) == expected);
+        REQUIRE(RenderStats::collect().shadowRays == 1);
+    }
+
     SECTION("Shading an intersection from the inside") {
         World w = World::makeDefaultWorld();
         w.getPointLight(0).position = Tuple::point(0, 0.25, 0);
@@ -89,7 +119,7 @@ TEST_CASE("World functionality", "[world]") {
         w.addLight(PointLight(Tuple::point(0, 0, -10), Color(1, 1, 1)));
         w.addObject(Sphere::createSphere());
         std::shared_ptr<Sphere> s2 = Sphere::createSphere();
-        s2->setTransform(Matrix::translation(0, 0, 10));
+        s2->setTransform(Matrix4::translation(0, 0, 10));
         w.addObject(s2);
         Ray r = Ray(Tuple::point(0, 0, 5), Tuple::vector(0, 0, 1));
         Intersection i = Intersection(4, s2);
@@ -107,6 +137,40 @@ TEST_CASE("World functionality", "[world]") {
         REQUIRE(!w.isShadowed(lightPosition, Tuple::point(-5, -5, -5)));
     }
 
+    SECTION("occluded() only reports blockers inside the ray interval") {
+        World w = World::makeDefaultWorld();
+        Ray r = Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, 1));
+        REQUIRE(w.occluded(r, 10));
+        REQUIRE(w.occluded(r, 4.1));
+        REQUIRE(!w.occluded(r, 3.9));
+        REQUIRE(!w.occluded(Ray(Tuple::point(0, 0, -5), Tuple::vector(0, 0, -1)), 100));
+    }
+
+    SECTION("occluded() ignores blockers behind the ray origin") {
+        World w = World::makeDefaultWorld();
+        Ray r = Ray(Tuple::point(0, 0, 5), Tuple::vector(0, 0, 1));
+        REQUIRE(!w.occluded(r, 100));
+    }
+
+    SECTION("occluded() agrees with and without an acceleration structure") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Plane> plane = Plane::createPlane();
+        plane->setTransform(Matrix4::translation(0, -2, 0));
+        w.addObject(plane);
+        std::vector<Ray> rays;
+        for (int i = 0; i < 30; i++) {
+            rays.push_back(Ray(Tuple::point(-3, 0.9, -5), Tuple::normalize(Tuple::vector((i % 6) * 0.3, (i / 6) * -0.2, 1))));
+        }
+        std::vector<bool> expected;
+        for (const Ray &r : rays) {
+            expected.push_back(w.occluded(r, 8));
+        }
+        w.buildAccelerationStructure();
+        for (int i = 0; i < static_cast<int>(rays.size()); i++) {
+            REQUIRE(w.occluded(rays[i], 8) == expected[i]);
+        }
+    }
+
     SECTION("Point lights evaluate the light intensity at a given point") {
         World w = World::makeDefaultWorld();
         REQUIRE(w.intensityAt(w.getPointLight(0), Tuple::point(0, 1.00001, 0)) == 1.0);
@@ -134,6 +198,30 @@ TEST_CASE("World functionality", "[world]") {
         REQUIRE(w.intensityAt(light, Tuple::point(0, 0, -2)) == 1.0);
     }
 
+    SECTION("Adaptive area light sampling only spends every sample in penumbrae") {
+        World w = World::makeDefaultWorld();
+
+        Tuple corner = Tuple::point(-0.5, -0.5, -5);
+        Color intensity = Color::Color(1, 1, 1);
+        Tuple v1 = Tuple::vector(1, 0, 0);
+        Tuple v2 = Tuple::vector(0, 1, 0);
+        AreaLight light = AreaLight(intensity, corner, v1, 2, v2, 2, false);
+        light.probeSteps = 2;
+
+        RenderStats::reset();
+        REQUIRE(w.intensityAt(light, Tuple::point(0, 0, 2)) == 0.0);
+        REQUIRE(w.intensityAt(light, Tuple::point(0, 0, -2)) == 1.0);
+        REQUIRE(RenderStats::collect().shadowRays == 2 * light.probeCount());
+
+        REQUIRE(w.intensityAt(light, Tuple::point(1, -1, 2)) == 0.25);
+        REQUIRE(w.intensityAt(light, Tuple::point(1.5, 0, 2)) == 0.5);
+        REQUIRE(w.intensityAt(light, Tuple::point(1.25, 1.25, 3)) == 0.75);
+
+        // A single probe can't disagree with itself, so it samples the whole light like no probes at all.
+        light.probeSteps = 1;
+        REQUIRE(w.intensityAt(light, Tuple::point(1.5, 0, 2)) == 0.5);
+    }
+
     SECTION("The reflected color for a nonreflective material") {
         World w = World::makeDefaultWorld();
         Ray r = Ray(Tuple::point(0, 0, 0), Tuple::vector(0, 0, 1));
@@ -148,7 +236,7 @@ TEST_CASE("World functionality", "[world]") {
     SECTION("The reflected color for a reflective material") {
         World w = World::makeDefaultWorld();
         std::shared_ptr<Shape> shape = Plane::createPlane();
-        shape->setTransform(Matrix::translation(0, -1, 0));
+        shape->setTransform(Matrix4::translation(0, -1, 0));
         shape->getMaterial().reflective = 0.5;
         w.addObject(shape);
 
@@ -162,7 +250,7 @@ TEST_CASE("World functionality", "[world]") {
     SECTION("shadeHit() with a reflective material") {
         World w = World::makeDefaultWorld();
         std::shared_ptr<Shape> shape = Plane::createPlane();
-        shape->setTransform(Matrix::translation(0, -1, 0));
+        shape->setTransform(Matrix4::translation(0, -1, 0));
         shape->getMaterial().reflective = 0.5;
         w.addObject(shape);
 
@@ -176,7 +264,7 @@ TEST_CASE("World functionality", "[world]") {
     SECTION("The reflected color at the maximum recursive depth") {
         World w = World::makeDefaultWorld();
         std::shared_ptr<Shape> shape = Plane::createPlane();
-        shape->setTransform(Matrix::translation(0, -1, 0));
+        shape->setTransform(Matrix4::translation(0, -1, 0));
         shape->getMaterial().reflective = 0.5;
         w.addObject(shape);
 
@@ -253,7 +341,7 @@ TEST_CASE("World functionality", "[world]") {
     SECTION("shade_hit() with a transparent material") {
         World w = World::makeDefaultWorld();
         std::shared_ptr<Plane> plane = Plane::createPlane();
-        plane->setTransform(Matrix::translation(0, -1, 0));
+        plane->setTransform(Matrix4::translation(0, -1, 0));
         plane->getMaterial().transparency = 0.5;
         plane->getMaterial().refractiveIndex = 1.5;
         w.addObject(plane);
@@ -261,7 +349,7 @@ TEST_CASE("World functionality", "[world]") {
         std::shared_ptr<Sphere> sphere = Sphere::createSphere();
         sphere->getMaterial().color = Color(1, 0, 0);
         sphere->getMaterial().ambient = 0.5;
-        sphere->setTransform(Matrix::translation(0, -3.5, -0.5));
+        sphere->setTransform(Matrix4::translation(0, -3.5, -0.5));
         w.addObject(sphere);
 
         Ray r = Ray(Tuple::point(0, 0, -3), Tuple::vector(0, -sqrt(2.0) / 2.0, sqrt(2.0) / 2.0));
@@ -274,7 +362,7 @@ TEST_CASE("World functionality", "[world]") {
     SECTION("shade_hit() with a reflective, transparent material") {
         World w = World::makeDefaultWorld();
         std::shared_ptr<Plane> plane = Plane::createPlane();
-        plane->setTransform(Matrix::translation(0, -1, 0));
+        plane->setTransform(Matrix4::translation(0, -1, 0));
         plane->getMaterial().transparency = 0.5;
         plane->getMaterial().reflective = 0.5;
         plane->getMaterial().refractiveIndex = 1.5;
@@ -283,7 +371,7 @@ TEST_CASE("World functionality", "[world]") {
         std::shared_ptr<Sphere> sphere = Sphere::createSphere();
         sphere->getMaterial().color = Color(1, 0, 0);
         sphere->getMaterial().ambient = 0.5;
-        sphere->setTransform(Matrix::translation(0, -3.5, -0.5));
+        sphere->setTransform(Matrix4::translation(0, -3.5, -0.5));
         w.addObject(sphere);
 
         Ray r = Ray(Tuple::point(0, 0, -3), Tuple::vector(0, -sqrt(2.0) / 2.0, sqrt(2.0) / 2.0));
@@ -292,4 +380,139 @@ TEST_CASE("World functionality", "[world]") {
         Color c = w.shadeHit(h, 5);
         REQUIRE(c == Color(0.93391, 0.69643, 0.69243));
     }
+
+    SECTION("The bounce limit of a world stops the reflections") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Shape> shape = Plane::createPlane();
+        shape->setTransform(Matrix4::translation(0, -1, 0));
+        shape->getMaterial().reflective = 0.5;
+        w.addObject(shape);
+        REQUIRE(w.getMaxBounces() == World::MAX_REFLECTION_BOUNCES);
+
+        Ray r = Ray(Tuple::point(0, 0, -3), Tuple::vector(0, -sqrt(2.0) / 2.0, sqrt(2.0) / 2.0));
+        Intersection i = Intersection::Intersection(sqrt(2.0), shape);
+        Hit h = i.prepareHit(r, { i });
+        REQUIRE(w.colorAt(r) == w.shadeHit(h, World::MAX_REFLECTION_BOUNCES));
+
+        w.setMaxBounces(0);
+        REQUIRE(w.colorAt(r) == w.shadeHit(h, 0));
+        REQUIRE(!(w.colorAt(r) == w.shadeHit(h, 1)));
+    }
+
+    SECTION("Secondary rays traced in packets give the colors of single rays") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Plane> floor = Plane::createPlane();
+        floor->setTransform(Matrix4::translation(0, -1, 0));
+        floor->getMaterial().reflective = 0.5;
+        w.addObject(floor);
+        std::shared_ptr<Sphere> glass = Sphere::createSphere();
+        glass->setTransform(Matrix4::translation(1.5, 0, 0) * Matrix4::scaling(0.5, 0.5, 0.5));
+        glass->getMaterial().transparency = 0.9;
+        glass->getMaterial().reflective = 0.5;
+        glass->getMaterial().refractiveIndex = 1.5;
+        w.addObject(glass);
+        w.buildAccelerationStructure();
+
+        RayPacket packet;
+        for (int lane = 0; lane < RayPacket::MAX_SIZE; lane++) {
+            packet.add(Ray(Tuple::point(0, 0.5, -5), Tuple::normalize(Tuple::vector(lane * 0.025, -0.12, 1))));
+        }
+        Color colors[RayPacket::MAX_SIZE];
+        w.colorAt(packet, colors);
+        for (int lane = 0; lane < packet.size; lane++) {
+            REQUIRE(colors[lane] == w.colorAt(packet.getRay(lane)));
+        }
+    }
+
+    SECTION("Russian roulette leaves rays above the threshold alone") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Shape> shape = Plane::createPlane();
+        shape->setTransform(Matrix4::translation(0, -1, 0));
+        shape->getMaterial().reflective = 0.5;
+        w.addObject(shape);
+
+        Ray r = Ray(Tuple::point(0, 0, -3), Tuple::vector(0, -sqrt(2.0) / 2.0, sqrt(2.0) / 2.0));
+        Intersection i = Intersection::Intersection(sqrt(2.0), shape);
+        Hit h = i.prepareHit(r, { i });
+        Color expected = w.shadeHit(h, 1);
+
+        w.setRouletteThreshold(0.4);
+        RenderStats::reset();
+        REQUIRE(w.shadeHit(h, 1) == expected);
+        REQUIRE(RenderStats::collect().terminatedRays == 0);
+    }
+
+    SECTION("Russian roulette keeps the expected color") {
+        World w = World();
+        w.addLight(PointLight(Tuple::point(0, 10, 0), Color(1, 1, 1)));
+        std::shared_ptr<Shape> sky = Sphere::createSphere();
+        sky->setTransform(Matrix4::scaling(100, 100, 100));
+        sky->setMaterial(Material(Color(1, 1, 1), 1, 0, 0, 200, 0, 0, 1));
+        w.addObject(sky);
+        std::shared_ptr<Shape> mirror = Plane::createPlane();
+        mirror->setMaterial(Material(Color(0, 0, 0), 0, 0, 0, 200, 0.5, 0, 1));
+        w.addObject(mirror);
+        w.setRouletteThreshold(1.0);
+
+        RenderStats::reset();
+        const int rays = 2000;
+        double total = 0.0;
+        for (int k = 0; k < rays; k++) {
+            Ray r = Ray(Tuple::point(k * 0.01, 1, 0), Tuple::vector(0, -1, 1));
+            Color c = w.colorAt(r);
+            REQUIRE(((c == Color(0, 0, 0)) || (c == Color(1, 1, 1))));
+            total += c.red;
+        }
+        RenderStats stats = RenderStats::collect();
+        REQUIRE(stats.reflectionRays + stats.terminatedRays == rays);
+        REQUIRE(stats.terminatedRays > 0);
+        REQUIRE(total / rays == Approx(0.5).margin(0.05));
+    }
+
+    SECTION("Intersecting a world with an acceleration structure matches the linear scan") {
+        World w = World::makeDefaultWorld();
+        std::shared_ptr<Plane> plane = Plane::createPlane();
+        plane->setTransform(Matrix4::translation(0, -1, 0));
+        w.addObject(plane);
+        for (int i = 0; i < 50; i++) {
+            std::shared_ptr<Sphere> sphere = Sphere::createSphere();
+            sphere->setTransform(Matrix4::translation((i % 10) - 5.0, (i / 10) * 0.7, 3.0 + (i % 3)) * Matrix4::scaling(0.3, 0.3, 0.3));
+            w.addObject(sphere);
+        }
+
+        std::vector<Ray> rays;
+        for (int i = 0; i < 40; i++) {
+            rays.push_back(Ray(Tuple::point(0, 0.5, -5), Tuple::normalize(Tuple::vector((i % 8) * 0.15 - 0.5, (i / 8) * 0.1 - 0.2, 1))));
+        }
+        std::vector<std::vector<Intersection>> linear, linearToHit;
+        for (const Ray &r : rays) {
+            linear.push_back(w.intersects(r));
+            linearToHit.push_back(w.intersectsToHit(r));
+        }
+
+        w.buildAccelerationStructure();
+        REQUIRE(w.hasAccelerationStructure());
+        for (int i = 0; i < static_cast<int>(rays.size()); i++) {
+            std::vector<Intersection> xs = w.intersects(rays[i]);
+            REQUIRE(xs.size() == linear[i].size());
+            for (int j = 0; j < static_cast<int>(xs.size()); j++) {
+                REQUIRE(xs[j].getT() == Approx(linear[i][j].getT()));
+            }
+
+            std::optional<Intersection> expected = Intersection::hit(linear[i]);
+            std::optional<Intersection> actual = Intersection::hit(w.intersectsToHit(rays[i]));
+            REQUIRE(expected.has_value() == actual.has_value());
+            if (expected.has_value()) {
+                REQUIRE(actual.value() == expected.value());
+            }
+            REQUIRE(Intersection::hit(linearToHit[i]).has_value() == expected.has_value());
+        }
+    }
+
+    SECTION("Adding an object drops the acceleration structure") {
+        World w = World::makeDefaultWorld();
+        w.buildAccelerationStructure();
+        w.addObject(Sphere::createSphere());
+        REQUIRE(!w.hasAccelerationStructure());
+    }
 }
\ No newline at end of file